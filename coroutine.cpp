@@ -0,0 +1,90 @@
+#include "espp/coroutine.h"
+#include "espp/critical_section.h"
+
+#include <algorithm>
+
+namespace espp {
+
+void CoroutineScheduler::Add(Coroutine& coroutine)
+{
+    {
+        CriticalSection lock;
+        coroutine._state = Coroutine::State::ready;
+        coroutine._next = _added;
+        _added = &coroutine;
+    }
+    if(_handle != nullptr) {
+        Notify(0);
+    }
+}
+
+TickType_t CoroutineScheduler::Step(uint32_t events)
+{
+    const TickType_t now = xTaskGetTickCount();
+    TickType_t wait = portMAX_DELAY;
+
+    // only scheduler task links into _first, so it's walked without lock
+    Coroutine* added;
+    {
+        CriticalSection lock;
+        added = _added;
+        _added = nullptr;
+    }
+    while(added != nullptr) {
+        Coroutine* const next = added->_next;
+        added->_next = _first;
+        _first = added;
+        added = next;
+    }
+
+    Coroutine* coroutine = _first;
+    Coroutine** link = &_first;
+    while(coroutine != nullptr) {
+        coroutine->_events |= events;
+        const bool is_sleeping = coroutine->_state == Coroutine::State::sleep
+            && static_cast<int32_t>(coroutine->_wake_tick - now) > 0;
+        if(!is_sleeping) {
+            coroutine->_state = coroutine->Resume();
+        }
+        switch(coroutine->_state) {
+            case Coroutine::State::ready:
+                wait = 0;
+                break;
+            case Coroutine::State::wait:
+                if(_poll_ticks < wait) {
+                    wait = _poll_ticks;
+                }
+                break;
+            case Coroutine::State::sleep: {
+                const auto remain = static_cast<int32_t>(coroutine->_wake_tick - now);
+                const TickType_t sleep = remain > 0 ? static_cast<TickType_t>(remain) : 0;
+                if(sleep < wait) {
+                    wait = sleep;
+                }
+                break;
+            }
+            case Coroutine::State::done: {
+                VERBOSE << "Coroutine is done";
+                *link = coroutine->_next;
+                coroutine = coroutine->_next;
+                continue;
+            }
+        }
+        link = &coroutine->_next;
+        coroutine = coroutine->_next;
+    }
+    return wait;
+}
+
+void CoroutineScheduler::run()
+{
+    uint32_t events = 0;
+    for(;;) {
+        // ready coroutines still block for a tick, otherwise lower priority tasks and IDLE starve
+        const TickType_t wait = std::max<TickType_t>(Step(events), 1);
+        events = 0;
+        xTaskNotifyWait(0, 0xFFFFFFFFu, &events, wait);
+    }
+}
+
+}
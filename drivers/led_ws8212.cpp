@@ -1,4 +1,5 @@
 #include "espp/drivers/led_ws8212.h"
+#include "espp/drivers/led_effects.h"
 #include "espp/utils/low_level.h"
 
 
@@ -76,6 +77,27 @@ inline void __attribute__((always_inline)) Send32Bit(uint32_t pinMask, uint32_t
     }
 }
 
+/**
+ * Zero pins go low after T0H, the rest after T1H
+ */
+inline void __attribute__((always_inline)) SendParallelBit(uint32_t pinMask, uint32_t zeroMask)
+{
+    GPIO.out_w1ts = pinMask;
+    Wait(T0H);
+    GPIO.out_w1tc = zeroMask;
+    Wait(T1H - T0H);
+    GPIO.out_w1tc = pinMask;
+    Wait(T1L);
+}
+
+inline void __attribute__((always_inline)) SendPlanes(uint32_t mask, const uint32_t* lut, const uint8_t* planes, uint32_t size)
+{
+    const auto lastPlane = planes + size;
+    for(auto plane = planes; plane != lastPlane; ++plane) {
+        SendParallelBit(mask, mask & ~(lut[*plane >> 4u] | lut[16 + (*plane & 0x0Fu)]));
+    }
+}
+
 inline void __attribute__((always_inline)) SendData(uint32_t mask, uint32_t* buffer, uint32_t size)
 {
     const auto lastItem = buffer + size;
@@ -86,13 +108,38 @@ inline void __attribute__((always_inline)) SendData(uint32_t mask, uint32_t* buf
 
 }
 
-void IRAM_ATTR SendLed(uint32_t mask, uint32_t* buffer, uint32_t size)
+void IRAM_ATTR SendLedFrame(uint32_t mask, uint32_t* buffer, uint32_t size)
 {
     GPIO.out_w1tc = mask;
     vPortETSIntrLock();
     SendData(mask, buffer, size);
     GPIO.out_w1tc = mask;
     vPortETSIntrUnlock();
+}
+
+void IRAM_ATTR SendLed(uint32_t mask, uint32_t* buffer, uint32_t size)
+{
+    SendLedFrame(mask, buffer, size);
+    vTaskDelay(pdMS_TO_TICKS(RST_MS));
+}
+
+void IRAM_ATTR SendLedParallel(uint32_t mask, const uint32_t* lut, const uint8_t* const* strips, uint32_t count,
+                               uint32_t size)
+{
+    uint8_t rows[8] = {};
+    uint8_t planes[8];
+    GPIO.out_w1tc = mask;
+    vPortETSIntrLock();
+    for(uint32_t byte = 0; byte < size; ++byte) {
+        // takes a few dozens of cycles, which is far below the latch time
+        for(uint32_t idx = 0; idx < count; ++idx) {
+            rows[idx] = strips[idx][byte];
+        }
+        Transpose8x8(rows, planes);
+        SendPlanes(mask, lut, planes, 8);
+    }
+    GPIO.out_w1tc = mask;
+    vPortETSIntrUnlock();
     vTaskDelay(pdMS_TO_TICKS(RST_MS));
 }
 
@@ -291,6 +338,63 @@ uint32_t testSendDataResult()
     return res;
 }
 
+uint32_t IRAM_ATTR __attribute__((noinline))
+testSendParallel(uint32_t mask, const uint32_t* lut, const uint8_t* planes)
+{
+    GPIO.out_w1tc = 0;
+    Wait(50000);
+    DECLARE_CYCLE_COUNT_VAR(start);
+    SendPlanes(mask, lut, planes, 96);
+    DECLARE_CYCLE_COUNT_VAR(end);
+    return end - start;
+}
+
+/** Cycles of output stage for 30 LEDs with dithering */
+uint32_t testOutputStageResult()
+{
+    static LedOutputStage<30> stage(220, 0x80, true);
+    uint8_t colors[LedOutputStage<30>::CHANNELS];
+    for(std::size_t idx = 0; idx < sizeof(colors); ++idx) {
+        colors[idx] = static_cast<uint8_t>(idx * 8);
+    }
+    vPortETSIntrLock();
+    DECLARE_CYCLE_COUNT_VAR(start);
+    stage.Apply(colors);
+    DECLARE_CYCLE_COUNT_VAR(end);
+    vPortETSIntrUnlock();
+    return end - start;
+}
+
+/** Rainbow over 30 LEDs */
+uint32_t testRainbowResult()
+{
+    LedColor colors[30];
+    vPortETSIntrLock();
+    DECLARE_CYCLE_COUNT_VAR(start);
+    led::Rainbow(colors, 30, 0, 0x0880);
+    DECLARE_CYCLE_COUNT_VAR(end);
+    vPortETSIntrUnlock();
+    return end - start;
+}
+
+/** Should take same time as testSendDataResult */
+uint32_t testSendParallelResult()
+{
+    uint32_t lut[32];
+    for(uint32_t nibble = 0; nibble < 16; ++nibble) {
+        lut[nibble] = ((nibble & 0x8) != 0 ? 0x4 : 0) | ((nibble & 0x4) != 0 ? 0x20 : 0);
+        lut[16 + nibble] = 0;
+    }
+    uint8_t planes[96];
+    for(auto& plane: planes) {
+        plane = 0xC0;
+    }
+    vPortETSIntrLock();
+    auto res = testSendParallel(0x24, lut, planes);
+    vPortETSIntrUnlock();
+    return res;
+}
+
 }
 #endif
 
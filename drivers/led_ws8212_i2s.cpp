@@ -0,0 +1,86 @@
+#include "espp/drivers/led_ws8212_i2s.h"
+#include "espp/drivers/ws2812_encoder.h"
+#include "espp/utils/macros.h"
+
+#include "driver/i2s.h"
+
+#include <algorithm>
+
+namespace espp {
+
+namespace {
+
+const std::size_t CHUNK_BYTES = 32;
+
+}
+
+LedI2s::LedI2s(GpioPin& pin, std::size_t dma_buffers):
+    _dma_buffers(dma_buffers)
+{
+    ESPP_CHECK(pin.pin() == GPIO_NUM_3);
+}
+
+LedI2s::~LedI2s()
+{
+    if(_is_installed) {
+        i2s_driver_uninstall(I2S_NUM_0);
+    }
+}
+
+bool LedI2s::_Install(std::size_t samples)
+{
+    if(_dma_buffers == AUTO_DMA_BUFFERS) {
+        // driver keeps one buffer for DMA, so queue holds one less
+        _dma_buffers = (samples + RESET_SAMPLES + DMA_BUFFER_LENGTH - 1) / DMA_BUFFER_LENGTH + 1;
+    }
+    if(_dma_buffers < MIN_DMA_BUFFERS) {
+        _dma_buffers = MIN_DMA_BUFFERS;
+    } else if(_dma_buffers > MAX_DMA_BUFFERS) {
+        _dma_buffers = MAX_DMA_BUFFERS;
+    }
+    INFO << "Install I2S LED output with" << _dma_buffers << "DMA buffers";
+    i2s_config_t config = {};
+    config.mode = static_cast<i2s_mode_t>(I2S_MODE_MASTER | I2S_MODE_TX);
+    config.sample_rate = Ws2812I2sEncoder::SAMPLE_RATE;
+    config.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT;
+    config.channel_format = I2S_CHANNEL_FMT_RIGHT_LEFT;
+    config.communication_format = I2S_COMM_FORMAT_I2S_MSB;
+    config.dma_buf_count = _dma_buffers;
+    config.dma_buf_len = DMA_BUFFER_LENGTH;
+    config.tx_desc_auto_clear = true;
+    if(i2s_driver_install(I2S_NUM_0, &config, 0, nullptr) != ESP_OK) {
+        ERROR << "Can't install I2S driver";
+        return false;
+    }
+
+    i2s_pin_config_t pins = {};
+    pins.data_out_en = 1;
+    if(i2s_set_pin(I2S_NUM_0, &pins) != ESP_OK) {
+        ERROR << "Can't set I2S pins";
+        i2s_driver_uninstall(I2S_NUM_0);
+        return false;
+    }
+    _is_installed = true;
+    return true;
+}
+
+void LedI2s::Send(uint32_t* buffer, UBaseType_t size)
+{
+    const std::size_t length = size * sizeof(uint32_t);
+    if(!_is_installed && !_Install(length)) {
+        return;
+    }
+    const auto* data = reinterpret_cast<const uint8_t*>(buffer);
+    uint32_t chunk[CHUNK_BYTES];
+    std::size_t written;
+    for(std::size_t offset = 0; offset < length; offset += CHUNK_BYTES) {
+        const std::size_t count = std::min(CHUNK_BYTES, length - offset);
+        Ws2812I2sEncoder::Encode(data + offset, count, chunk);
+        // blocks only if frame is bigger than free DMA buffers
+        i2s_write(I2S_NUM_0, chunk, count * sizeof(uint32_t), &written, portMAX_DELAY);
+    }
+    const uint32_t reset[RESET_SAMPLES] = {};
+    i2s_write(I2S_NUM_0, reset, sizeof(reset), &written, portMAX_DELAY);
+}
+
+}
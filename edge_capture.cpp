@@ -0,0 +1,64 @@
+#include "espp/edge_capture.h"
+
+#include "esp8266/eagle_soc.h"
+
+namespace espp {
+
+bool EdgeCapture::Add(GpioPin& pin)
+{
+    Slot& slot = _slots[pin.pin()];
+    slot.capture = this;
+    slot.level = pin.HasLowLevel() ? 0 : 1;
+    if(gpio_set_intr_type(pin.pin(), GPIO_INTR_ANYEDGE) != ESP_OK
+       || gpio_isr_handler_add(pin.pin(), _Isr, &slot) != ESP_OK) {
+        ERROR << "Can't add capture ISR for GPIO" << pin.pin();
+        slot.capture = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void EdgeCapture::Remove(GpioPin& pin)
+{
+    gpio_isr_handler_remove(pin.pin());
+    gpio_set_intr_type(pin.pin(), GPIO_INTR_DISABLE);
+    _slots[pin.pin()].capture = nullptr;
+}
+
+void EdgeCapture::ResetStats()
+{
+    _stats = {};
+    _stats.min_interval = UINT32_MAX;
+}
+
+void IRAM_ATTR EdgeCapture::_Isr(void* arg)
+{
+    const uint32_t start = soc_get_ccount();
+    auto* slot = reinterpret_cast<Slot*>(arg);
+    EdgeCapture& capture = *slot->capture;
+    const auto pin = static_cast<uint8_t>(slot - capture._slots.data());
+    const auto level = static_cast<uint8_t>((GPIO.in >> pin) & 0x1);
+
+    Stats& stats = capture._stats;
+    if(level == slot->level) {
+        // two edges were merged into one interrupt
+        stats.missed += 1;
+    }
+    slot->level = level;
+    if(capture._queue.PushFromISR(Edge{start, pin, level})) {
+        stats.edges += 1;
+    } else {
+        stats.overflows += 1;
+    }
+
+    if(capture._last_isr != 0 && start - capture._last_isr < stats.min_interval) {
+        stats.min_interval = start - capture._last_isr;
+    }
+    capture._last_isr = start;
+    const uint32_t cycles = soc_get_ccount() - start;
+    if(cycles > stats.max_isr_cycles) {
+        stats.max_isr_cycles = cycles;
+    }
+}
+
+}
@@ -0,0 +1,97 @@
+#include "espp/gpio.h"
+#include "espp/utils/low_level.h"
+
+namespace espp {
+
+#ifdef ENABLE_TEST
+namespace testing {
+
+namespace {
+
+using TestPin = GpioFixedPin<GPIO_NUM_2>;
+using TestPort = GpioPort<GpioFixedPin<GPIO_NUM_2>, GpioFixedPin<GPIO_NUM_4>, GpioFixedPin<GPIO_NUM_5>>;
+
+}
+
+uint32_t IRAM_ATTR __attribute__((noinline)) testGpioPinRead(GpioPin& pin, bool& level)
+{
+    DECLARE_CYCLE_COUNT_VAR(start);
+    level = pin.HasLowLevel();
+    DECLARE_CYCLE_COUNT_VAR(end);
+    return end - start;
+}
+
+uint32_t testGpioPinReadResult()
+{
+    GpioPin pin(GPIO_NUM_2);
+    bool level;
+    vPortETSIntrLock();
+    const auto res = testGpioPinRead(pin, level);
+    vPortETSIntrUnlock();
+    return res;
+}
+
+uint32_t IRAM_ATTR __attribute__((noinline)) testGpioFixedPinRead(bool& level)
+{
+    DECLARE_CYCLE_COUNT_VAR(start);
+    level = TestPin::HasLowLevel();
+    DECLARE_CYCLE_COUNT_VAR(end);
+    return end - start;
+}
+
+uint32_t testGpioFixedPinReadResult()
+{
+    bool level;
+    vPortETSIntrLock();
+    const auto res = testGpioFixedPinRead(level);
+    vPortETSIntrUnlock();
+    return res;
+}
+
+uint32_t IRAM_ATTR testGpioFixedPinSetResult()
+{
+    GPIO.out_w1tc = 0;
+    vPortETSIntrLock();
+    DECLARE_CYCLE_COUNT_VAR(start);
+    TestPin::SetHighLevel();
+    TestPin::SetLowLevel();
+    DECLARE_CYCLE_COUNT_VAR(end);
+    vPortETSIntrUnlock();
+    return end - start;
+}
+
+uint32_t IRAM_ATTR __attribute__((noinline)) testGpioPortWrite(uint32_t value)
+{
+    DECLARE_CYCLE_COUNT_VAR(start);
+    TestPort::Write(value);
+    DECLARE_CYCLE_COUNT_VAR(end);
+    return end - start;
+}
+
+uint32_t testGpioPortWriteResult()
+{
+    GPIO.out_w1tc = 0;
+    vPortETSIntrLock();
+    const auto res = testGpioPortWrite(0x5);
+    vPortETSIntrUnlock();
+    return res;
+}
+
+uint32_t IRAM_ATTR testGpioWriteBatchResult()
+{
+    GpioWriteBatch batch;
+    batch.Write<TestPort>(0x3);
+    batch.SetHigh(GpioFixedPin<GPIO_NUM_12>::MASK);
+    GPIO.out_w1tc = 0;
+    vPortETSIntrLock();
+    DECLARE_CYCLE_COUNT_VAR(start);
+    batch.Apply();
+    DECLARE_CYCLE_COUNT_VAR(end);
+    vPortETSIntrUnlock();
+    return end - start;
+}
+
+}
+#endif
+
+}
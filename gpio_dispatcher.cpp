@@ -0,0 +1,134 @@
+#include "espp/gpio_dispatcher.h"
+
+#include <algorithm>
+
+#include "esp8266/eagle_soc.h"
+
+#include "espp/critical_section.h"
+
+namespace espp {
+
+bool GpioDispatcher::Add(GpioPin& pin, gpio_int_type_t type, GpioEventHandler& handler, uint32_t debounce_ms)
+{
+    PinSlot& slot = _pins[pin.pin()];
+    const uint8_t stable_level = pin.HasLowLevel() ? 0 : 1;
+    bool is_added = false;
+    {
+        // slot is read by dispatcher task
+        CriticalSection lock;
+        if(slot.handler == nullptr) {
+            slot.dispatcher = this;
+            slot.handler = &handler;
+            slot.debounce = pdMS_TO_TICKS(debounce_ms);
+            slot.edges = 0;
+            slot.stable_level = stable_level;
+            slot.glitch_filter = type == GPIO_INTR_ANYEDGE && debounce_ms > 0;
+            is_added = true;
+        }
+    }
+    if(!is_added) {
+        ERROR << "GPIO" << pin.pin() << "is already dispatched";
+        return false;
+    }
+
+    if(gpio_set_intr_type(pin.pin(), type) != ESP_OK
+       || gpio_isr_handler_add(pin.pin(), _Isr, &slot) != ESP_OK) {
+        ERROR << "Can't add ISR for GPIO" << pin.pin();
+        CriticalSection lock;
+        slot.handler = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void GpioDispatcher::Remove(GpioPin& pin)
+{
+    gpio_isr_handler_remove(pin.pin());
+    gpio_set_intr_type(pin.pin(), GPIO_INTR_DISABLE);
+    PinSlot& slot = _pins[pin.pin()];
+    // dispatcher task can be in the middle of _OnEdge or _Settle of this slot
+    CriticalSection lock;
+    slot.handler = nullptr;
+    // pending burst of removed pin isn't delivered
+    slot.edges = 0;
+}
+
+void IRAM_ATTR GpioDispatcher::_Isr(void* arg)
+{
+    auto* slot = reinterpret_cast<PinSlot*>(arg);
+    const auto pin = static_cast<uint8_t>(slot - slot->dispatcher->_pins.data());
+    const GpioEvent event{soc_get_ccount(), pin, static_cast<uint8_t>((GPIO.in >> pin) & 0x1)};
+    slot->dispatcher->_queue.PushFromISR(event);
+}
+
+void GpioDispatcher::_OnEdge(const GpioEvent& event, TickType_t now)
+{
+    PinSlot& slot = _pins[event.pin];
+    if(slot.handler == nullptr) {
+        return;
+    }
+    slot.last = event;
+    slot.edges += 1;
+    slot.settle_tick = now + slot.debounce;
+}
+
+TickType_t GpioDispatcher::_Settle(TickType_t now)
+{
+    TickType_t wait = portMAX_DELAY;
+    for(auto& slot: _pins) {
+        GpioEventHandler* handler;
+        GpioEvent event;
+        unsigned int edges;
+        bool is_glitch;
+        {
+            // handler is called outside, so it can Remove its own pin
+            CriticalSection lock;
+            if(slot.edges == 0) {
+                continue;
+            }
+            const auto left = static_cast<int32_t>(slot.settle_tick - now);
+            if(left > 0) {
+                wait = std::min(wait, static_cast<TickType_t>(left));
+                continue;
+            }
+            edges = slot.edges;
+            slot.edges = 0;
+            handler = slot.handler;
+            if(handler == nullptr) {
+                continue;
+            }
+            event = slot.last;
+            is_glitch = slot.glitch_filter && event.level == slot.stable_level;
+            if(!is_glitch) {
+                slot.stable_level = event.level;
+            }
+        }
+        if(is_glitch) {
+            VERBOSE << "GPIO glitch" << event.pin << "edges" << edges;
+            _glitches += 1;
+            continue;
+        }
+        handler->OnGpioEvent(event, edges);
+    }
+    return wait;
+}
+
+void GpioDispatcher::run()
+{
+    TickType_t wait = portMAX_DELAY;
+    for(;;) {
+        _queue.Wait(wait);
+        GpioEvent events[8];
+        std::size_t count;
+        while((count = _queue.Pop(events, 8)) > 0) {
+            const TickType_t now = xTaskGetTickCount();
+            CriticalSection lock;
+            for(std::size_t idx = 0; idx < count; ++idx) {
+                _OnEdge(events[idx], now);
+            }
+        }
+        wait = _Settle(xTaskGetTickCount());
+    }
+}
+
+}
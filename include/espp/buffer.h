@@ -4,6 +4,7 @@
 #include <cstring>
 #include <ostream>
 #include <cassert>
+#include <array>
 
 namespace espp {
 
@@ -130,6 +131,45 @@ std::ostream& operator<<(std::ostream& s, const Buffer& buffer)
     return s;
 }
 
+/**
+ * Own fixed size storage without heap allocation.
+ *
+ * Length is number of used bytes and can't exceed size
+ */
+template<std::size_t size>
+class StaticBuffer: public Buffer {
+public:
+    StaticBuffer():
+        _storage()
+    {
+        Set(_storage.data(), 0);
+    }
+
+    std::size_t capacity() const
+    {
+        return size;
+    }
+
+    uint8_t* writeData()
+    {
+        return _storage.data();
+    }
+
+    void Resize(std::size_t length)
+    {
+        assert(length <= size);
+        Set(_storage.data(), length);
+    }
+
+    void Clear()
+    {
+        Resize(0);
+    }
+
+private:
+    std::array<uint8_t, size> _storage;
+};
+
 /**
  * Own string and store buffer
  */
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "espp/task.h"
+
+namespace espp {
+
+/**
+ * Stackless coroutine (protothread) executed by CoroutineScheduler.
+ *
+ * Local variables don't survive CO_* macros, so state has to be kept in members.
+ * Don't use switch inside Resume and don't put two CO_* macros on one line.
+ *
+ * Example
+ *
+ *      class Connect: public Coroutine {
+ *      public:
+ *          State Resume() override
+ *          {
+ *              CO_BEGIN();
+ *              CO_AWAIT(wifi.hasStationIp());
+ *              mqtt.Connect();
+ *              CO_AWAIT(mqtt.isConnected());
+ *              for(;;) {
+ *                  CO_AWAIT_EVENT(SENSOR_EDGE);
+ *                  PollSensor();
+ *                  CO_DELAY_MS(100);
+ *              }
+ *              CO_END();
+ *          }
+ *      };
+ */
+class Coroutine {
+public:
+    enum class State: uint8_t {
+        ready,      ///< yield and resume on next notification or tick
+        wait,       ///< wait condition: resume on event or poll
+        sleep,      ///< resume after delay
+        done,
+    };
+
+    virtual ~Coroutine() = default;
+
+    virtual State Resume() = 0;
+
+protected:
+    uint16_t _co_line = 0;
+
+    void SleepMs(uint32_t ms)
+    {
+        _wake_tick = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+    }
+
+    /** Return true and clear bits if any of them was notified */
+    bool TakeEvent(uint32_t bits)
+    {
+        const uint32_t result = _events & bits;
+        _events &= ~bits;
+        return result != 0;
+    }
+
+private:
+    friend class CoroutineScheduler;
+
+    Coroutine* _next = nullptr;
+    TickType_t _wake_tick = 0;
+    uint32_t _events = 0;
+    State _state = State::ready;
+};
+
+#define CO_BEGIN() switch(_co_line) { case 0:
+
+#define CO_YIELD() do { _co_line = __LINE__; return State::ready; case __LINE__:; } while(0)
+
+// comment markers are stripped from macros, so fall through into case label is marked by attribute
+#if defined(__GNUC__) && __GNUC__ >= 7
+#define CO_FALLTHROUGH __attribute__((fallthrough))
+#else
+#define CO_FALLTHROUGH
+#endif
+
+#define CO_AWAIT(condition) do { \
+        _co_line = __LINE__; CO_FALLTHROUGH; case __LINE__: if(!(condition)) { return State::wait; } \
+    } while(0)
+
+/** Wait any of bits notified by CoroutineScheduler::Notify */
+#define CO_AWAIT_EVENT(bits) CO_AWAIT(TakeEvent(bits))
+
+#define CO_DELAY_MS(ms) do { SleepMs(ms); _co_line = __LINE__; return State::sleep; case __LINE__:; } while(0)
+
+#define CO_END() } _co_line = 0; return State::done
+
+/**
+ * Run many coroutines in one task.
+ *
+ * Waiting coroutines are resumed on every notification and at least every poll period,
+ * so conditions like WiFi::hasStationIp or Mqtt::isConnected can be awaited without callbacks.
+ * GPIO interrupt handlers can wake coroutines by NotifyFromISR.
+ */
+class CoroutineScheduler: public Task {
+public:
+    explicit
+    CoroutineScheduler(const char* name = "coroutines", UBaseType_t priority = 1,
+                       configSTACK_DEPTH_TYPE stack_depth = 2048, uint32_t poll_ms = 50):
+        Task(name, priority, stack_depth),
+        _poll_ticks(pdMS_TO_TICKS(poll_ms))
+    {
+    }
+
+    /** Can be called from any task. Coroutine joins on next Step and is removed when it is done */
+    void Add(Coroutine& coroutine);
+
+    void Notify(uint32_t bits)
+    {
+        xTaskNotify(_handle, bits, eSetBits);
+    }
+
+    void NotifyFromISR(uint32_t bits)
+    {
+        BaseType_t woken = pdFALSE;
+        xTaskNotifyFromISR(_handle, bits, eSetBits, &woken);
+        if(woken == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+    }
+
+    void run();
+
+    /** Resume coroutines once. Return ticks to wait until next step, 0 if any coroutine is ready */
+    TickType_t Step(uint32_t events);
+
+private:
+    const TickType_t _poll_ticks;
+    Coroutine* _first = nullptr;     ///< touched only by scheduler task
+    Coroutine* _added = nullptr;     ///< guarded by CriticalSection
+};
+
+}
@@ -3,10 +3,32 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#ifdef ESPP_LOCK_ORDER_CHECK
+#include "espp/lock_order.h"
+#endif
+
 namespace espp {
 
 class CriticalSection {
 public:
+#ifdef ESPP_LOCK_ORDER_CHECK
+    /** Function name of the caller is used to report too long critical section */
+    CriticalSection(const char* function = __builtin_FUNCTION()):
+        _function(function)
+    {
+        taskENTER_CRITICAL();
+        LockOrder::OnCriticalEnter();
+    }
+
+    ~CriticalSection()
+    {
+        LockOrder::OnCriticalExit(_function);
+        taskEXIT_CRITICAL();
+    }
+
+private:
+    const char* const _function;
+#else
     CriticalSection()
     {
         taskENTER_CRITICAL();
@@ -16,6 +38,7 @@ public:
     {
         taskEXIT_CRITICAL();
     }
+#endif
 };
 
-}
\ No newline at end of file
+}
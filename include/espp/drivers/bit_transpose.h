@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+
+namespace espp {
+
+/**
+ * Transpose 8x8 bit matrix (Hacker's Delight, transpose8rS32).
+ *
+ * Bit (7 - col) of in[row] goes to bit (7 - row) of out[col],
+ * so out[k] collects bit (7 - k) of every input byte, MSB first.
+ * Always inlined, because LED output calls it from IRAM with interrupts disabled.
+ */
+inline __attribute__((always_inline))
+void Transpose8x8(const uint8_t in[8], uint8_t out[8])
+{
+    uint32_t x = (uint32_t(in[0]) << 24) | (uint32_t(in[1]) << 16) | (uint32_t(in[2]) << 8) | in[3];
+    uint32_t y = (uint32_t(in[4]) << 24) | (uint32_t(in[5]) << 16) | (uint32_t(in[6]) << 8) | in[7];
+    uint32_t t;
+
+    t = (x ^ (x >> 7)) & 0x00AA00AA;
+    x = x ^ t ^ (t << 7);
+    t = (y ^ (y >> 7)) & 0x00AA00AA;
+    y = y ^ t ^ (t << 7);
+
+    t = (x ^ (x >> 14)) & 0x0000CCCC;
+    x = x ^ t ^ (t << 14);
+    t = (y ^ (y >> 14)) & 0x0000CCCC;
+    y = y ^ t ^ (t << 14);
+
+    t = (x & 0xF0F0F0F0) | ((y >> 4) & 0x0F0F0F0F);
+    y = ((x << 4) & 0xF0F0F0F0) | (y & 0x0F0F0F0F);
+    x = t;
+
+    out[0] = static_cast<uint8_t>(x >> 24);
+    out[1] = static_cast<uint8_t>(x >> 16);
+    out[2] = static_cast<uint8_t>(x >> 8);
+    out[3] = static_cast<uint8_t>(x);
+    out[4] = static_cast<uint8_t>(y >> 24);
+    out[5] = static_cast<uint8_t>(y >> 16);
+    out[6] = static_cast<uint8_t>(y >> 8);
+    out[7] = static_cast<uint8_t>(y);
+}
+
+}
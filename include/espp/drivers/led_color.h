@@ -0,0 +1,75 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+
+namespace espp {
+
+/** Color of one WS2812 LED. Fields are in wire order (GRB) */
+struct LedColor{
+    uint8_t green;
+    uint8_t red;
+    uint8_t blue;
+
+    LedColor():
+        green(0), red(0), blue(0)
+    {}
+
+    LedColor(uint8_t R, uint8_t G, uint8_t B):
+        green(G), red(R), blue(B)
+    {}
+
+    static
+    uint8_t _Truncate(int32_t c)
+    {
+        return std::max(std::min(c, 0xFF), 0);
+    }
+
+    template<class T>
+    LedColor& operator=(const T& other)
+    {
+        green = other.green;
+        red = other.red;
+        blue = other.blue;
+        return *this;
+    }
+};
+
+/**
+ * Scale color by c / 255 (c above 0xFF is saturated).
+ * Multiply-shift by (c + 1) / 256 is exact for 0 and 0xFF
+ */
+inline
+LedColor operator*(const LedColor& color, uint32_t c)
+{
+    const uint32_t scale = std::min<uint32_t>(c, 0xFFu) + 1;
+    return {
+        static_cast<uint8_t>((color.red * scale) >> 8),
+        static_cast<uint8_t>((color.green * scale) >> 8),
+        static_cast<uint8_t>((color.blue * scale) >> 8)
+    };
+}
+
+inline
+LedColor operator*(uint32_t c, const LedColor& color)
+{
+    return (color * c);
+}
+
+inline
+LedColor operator+(const LedColor& color, int32_t c)
+{
+    return {
+        LedColor::_Truncate(color.red + c),
+        LedColor::_Truncate(color.green + c),
+        LedColor::_Truncate(color.blue + c),
+    };
+}
+
+inline
+LedColor operator-(const LedColor& color, int32_t c)
+{
+    return color + (-c);
+}
+
+}
@@ -0,0 +1,248 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "espp/drivers/led_color.h"
+
+/**
+ * Fixed-point LED effects.
+ *
+ * Kernels work on spans of LedColor (see LedStrip::colors) in tight loops without division.
+ */
+
+namespace espp {
+namespace led {
+
+/** v * s / 255 by multiply-shift, exact for s = 0 and s = 0xFF */
+inline
+uint8_t Scale8(uint8_t v, uint8_t s)
+{
+    return static_cast<uint8_t>((uint32_t(v) * (uint32_t(s) + 1)) >> 8);
+}
+
+/**
+ * HSV to RGB
+ *
+ * @param hue full circle is 256
+ */
+inline
+LedColor Hsv(uint8_t hue, uint8_t sat, uint8_t val)
+{
+    if(sat == 0) {
+        return {val, val, val};
+    }
+    // 6 regions of 43 hue steps, remainder scaled to 0..252
+    const uint8_t region = hue / 43;
+    const uint32_t rem = (hue - region * 43) * 6;
+    const uint8_t p = Scale8(val, 255 - sat);
+    const uint8_t q = Scale8(val, 255 - Scale8(sat, static_cast<uint8_t>(rem)));
+    const uint8_t t = Scale8(val, 255 - Scale8(sat, static_cast<uint8_t>(255 - rem)));
+    switch(region) {
+        case 0:
+            return {val, t, p};
+        case 1:
+            return {q, val, p};
+        case 2:
+            return {p, val, t};
+        case 3:
+            return {p, q, val};
+        case 4:
+            return {t, p, val};
+        default:
+            return {val, p, q};
+    }
+}
+
+/**
+ * Linear interpolation
+ *
+ * @param t 0 gives a, 0xFF gives b
+ */
+inline
+LedColor Lerp(const LedColor& a, const LedColor& b, uint8_t t)
+{
+    const uint32_t wb = uint32_t(t) + (t >> 7);
+    const uint32_t wa = 256 - wb;
+    return {
+        static_cast<uint8_t>((a.red * wa + b.red * wb) >> 8),
+        static_cast<uint8_t>((a.green * wa + b.green * wb) >> 8),
+        static_cast<uint8_t>((a.blue * wa + b.blue * wb) >> 8)
+    };
+}
+
+inline
+void Fill(LedColor* colors, std::size_t count, const LedColor& color)
+{
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        colors[idx] = color;
+    }
+}
+
+/** Multiply all colors by scale / 255. Used for fades */
+inline
+void Scale(LedColor* colors, std::size_t count, uint8_t scale)
+{
+    auto* bytes = reinterpret_cast<uint8_t*>(colors);
+    const uint32_t factor = uint32_t(scale) + 1;
+    for(std::size_t idx = 0; idx < 3 * count; ++idx) {
+        bytes[idx] = static_cast<uint8_t>((bytes[idx] * factor) >> 8);
+    }
+}
+
+/** Blend other into colors with weight t */
+inline
+void Blend(LedColor* colors, const LedColor* other, std::size_t count, uint8_t t)
+{
+    auto* bytes = reinterpret_cast<uint8_t*>(colors);
+    const auto* other_bytes = reinterpret_cast<const uint8_t*>(other);
+    const uint32_t wb = uint32_t(t) + (t >> 7);
+    const uint32_t wa = 256 - wb;
+    for(std::size_t idx = 0; idx < 3 * count; ++idx) {
+        bytes[idx] = static_cast<uint8_t>((bytes[idx] * wa + other_bytes[idx] * wb) >> 8);
+    }
+}
+
+/** Gradient from first to last color inclusive. Steps are 16.16 fixed-point */
+inline
+void Gradient(LedColor* colors, std::size_t count, const LedColor& first, const LedColor& last)
+{
+    if(count == 0) {
+        return;
+    }
+    const int32_t steps = count > 1 ? static_cast<int32_t>(count - 1) : 1;
+    // difference can be negative, so it's multiplied instead of shifted
+    const int32_t red_step = (int32_t(last.red) - first.red) * 65536 / steps;
+    const int32_t green_step = (int32_t(last.green) - first.green) * 65536 / steps;
+    const int32_t blue_step = (int32_t(last.blue) - first.blue) * 65536 / steps;
+    int32_t red = (int32_t(first.red) << 16) + 0x8000;
+    int32_t green = (int32_t(first.green) << 16) + 0x8000;
+    int32_t blue = (int32_t(first.blue) << 16) + 0x8000;
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        colors[idx] = LedColor(static_cast<uint8_t>(red >> 16), static_cast<uint8_t>(green >> 16),
+                               static_cast<uint8_t>(blue >> 16));
+        red += red_step;
+        green += green_step;
+        blue += blue_step;
+    }
+}
+
+/**
+ * Rainbow with full saturation
+ *
+ * @param delta_hue hue step between LEDs in 1/256 of hue unit
+ */
+inline
+void Rainbow(LedColor* colors, std::size_t count, uint8_t start_hue, uint16_t delta_hue, uint8_t val = 0xFF)
+{
+    uint32_t hue = uint32_t(start_hue) << 8;
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        colors[idx] = Hsv(static_cast<uint8_t>(hue >> 8), 0xFF, val);
+        hue += delta_hue;
+    }
+}
+
+/**
+ * 16 colors palette with interpolation between entries (wraps around)
+ */
+class Palette16 {
+public:
+    explicit
+    Palette16(const std::array<LedColor, 16>& entries):
+        _entries(entries)
+    {
+    }
+
+    LedColor At(uint8_t index) const
+    {
+        const uint8_t entry = index >> 4;
+        const auto t = static_cast<uint8_t>((index & 0x0F) << 4);
+        return Lerp(_entries[entry], _entries[(entry + 1) & 0x0F], t);
+    }
+
+private:
+    std::array<LedColor, 16> _entries;
+};
+
+/** Fill colors from palette starting at index with step delta_index (1/256 units) */
+inline
+void FillPalette(LedColor* colors, std::size_t count, const Palette16& palette,
+                 uint8_t start_index, uint16_t delta_index)
+{
+    uint32_t index = uint32_t(start_index) << 8;
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        colors[idx] = palette.At(static_cast<uint8_t>(index >> 8));
+        index += delta_index;
+    }
+}
+
+/**
+ * Fixed frame rate scheduler.
+ *
+ * Time units are up to caller (ticks, ms, cycles). Frame times don't drift,
+ * and if caller is late, up to max_catch_up frames are reported at once, the rest are dropped.
+ */
+class FrameScheduler {
+public:
+    /** Period must not be 0 */
+    explicit
+    FrameScheduler(uint32_t period, uint32_t max_catch_up = 4):
+        _period(period),
+        _max_catch_up(max_catch_up)
+    {
+        assert(period > 0);
+    }
+
+    void Start(uint32_t now)
+    {
+        _next = now;
+        _frame = 0;
+        _dropped = 0;
+    }
+
+    /** Return number of frames which are due. Caller advances animation by them */
+    uint32_t Poll(uint32_t now)
+    {
+        if(static_cast<int32_t>(now - _next) < 0) {
+            return 0;
+        }
+        uint32_t due = (now - _next) / _period + 1;
+        if(due > _max_catch_up) {
+            _dropped += due - _max_catch_up;
+            _next += (due - _max_catch_up) * _period;
+            due = _max_catch_up;
+        }
+        _next += due * _period;
+        _frame += due;
+        return due;
+    }
+
+    /** Time until the next frame */
+    uint32_t wait(uint32_t now) const
+    {
+        const auto left = static_cast<int32_t>(_next - now);
+        return left > 0 ? static_cast<uint32_t>(left) : 0;
+    }
+
+    uint32_t frame() const
+    {
+        return _frame;
+    }
+
+    uint32_t dropped() const
+    {
+        return _dropped;
+    }
+
+private:
+    const uint32_t _period;
+    const uint32_t _max_catch_up;
+    uint32_t _next = 0;
+    uint32_t _frame = 0;
+    uint32_t _dropped = 0;
+};
+
+}
+}
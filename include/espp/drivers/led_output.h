@@ -0,0 +1,100 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+namespace espp {
+
+/**
+ * Output stage of LED strip: gamma, brightness and temporal dithering in one pass.
+ *
+ * Gamma LUT maps 8 bit color to 8.8 fixed point intensity, so full color is 0xFF00.
+ * Brightness is applied by multiply-shift. With dithering, the fraction lost by truncation
+ * to 8 bit is kept per channel and added to the next frame, so low levels don't band.
+ * Dithering needs continuous refresh.
+ *
+ * @tparam length number of LEDs
+ */
+template<std::size_t length>
+class LedOutputStage{
+public:
+    static const std::size_t CHANNELS = 3 * length;
+    using Frame = std::array<uint32_t, (CHANNELS + 3) / 4>;
+
+    explicit
+    LedOutputStage(uint32_t gamma_x100 = 220, uint8_t brightness = 0xFF, bool dithering = true):
+        _brightness(brightness),
+        _dithering(dithering)
+    {
+        SetGamma(gamma_x100);
+        _frame.fill(0);
+        _error.fill(0);
+    }
+
+    /** Rebuild gamma LUT. 100 is linear */
+    void SetGamma(uint32_t gamma_x100)
+    {
+        const double gamma = gamma_x100 / 100.0;
+        for(uint32_t value = 0; value < _lut.size(); ++value) {
+            _lut[value] = static_cast<uint16_t>(std::pow(value / 255.0, gamma) * 0xFF00 + 0.5);
+        }
+    }
+
+    void SetBrightness(uint8_t brightness)
+    {
+        _brightness = brightness;
+    }
+
+    uint8_t brightness() const
+    {
+        return _brightness;
+    }
+
+    void SetDithering(bool dithering)
+    {
+        _dithering = dithering;
+        _error.fill(0);
+    }
+
+    bool dithering() const
+    {
+        return _dithering;
+    }
+
+    /** Convert CHANNELS bytes of colors into output frame */
+    uint32_t* Apply(const uint8_t* colors)
+    {
+        auto* out = reinterpret_cast<uint8_t*>(_frame.data());
+        // 0..256, so brightness 0 gives exactly 0 and 255 keeps full intensity.
+        // Value with fraction or rounding is at most 0xFF00 + 0xFF, so it fits 8.8
+        const uint32_t scale = uint32_t(_brightness) + (_brightness >> 7);
+        if(_dithering) {
+            for(std::size_t idx = 0; idx < CHANNELS; ++idx) {
+                const uint32_t value = ((_lut[colors[idx]] * scale) >> 8) + _error[idx];
+                _error[idx] = static_cast<uint8_t>(value);
+                out[idx] = static_cast<uint8_t>(value >> 8);
+            }
+        } else {
+            for(std::size_t idx = 0; idx < CHANNELS; ++idx) {
+                const uint32_t value = ((_lut[colors[idx]] * scale) >> 8) + 0x80;
+                out[idx] = static_cast<uint8_t>(value >> 8);
+            }
+        }
+        return _frame.data();
+    }
+
+    Frame& frame()
+    {
+        return _frame;
+    }
+
+private:
+    std::array<uint16_t, 256> _lut;
+    Frame _frame;
+    std::array<uint8_t, CHANNELS> _error;
+    uint8_t _brightness;
+    bool _dithering;
+};
+
+}
@@ -0,0 +1,221 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <cstring>
+#include <utility>
+
+#include "esp8266/eagle_soc.h"
+
+#include "espp/drivers/led_ws8212.h"
+#include "espp/mutex.h"
+#include "espp/task.h"
+
+namespace espp {
+
+/**
+ * Double-buffered LED strip with own output task.
+ *
+ * Application writes back buffer and calls Commit. Task takes the latest committed frame,
+ * skips it if it's equal to the last sent one, caps frame rate and keeps reset gap
+ * by cycle counter instead of sleeping after each frame. While output stage dithers,
+ * the last frame is resent at max frame rate even without commits.
+ *
+ * @tparam length number of LEDs
+ * @tparam Backend output with method SendFrame(uint32_t* buffer, UBaseType_t size)
+ */
+template<std::size_t length, class Backend = LedBitBang>
+class AsyncLedStrip: public Task {
+public:
+    /** WS2812B needs at least 280 us of low level between frames. Counted for 160 MHz CPU */
+    static const uint32_t RESET_CYCLES = 300 * 160;
+    static const uint32_t CYCLES_PER_SECOND = 160000000;
+
+    explicit
+    AsyncLedStrip(GpioPin& pin, uint32_t max_fps = 60, const char* name = "leds",
+                  UBaseType_t priority = 5, configSTACK_DEPTH_TYPE stack_depth = 2048):
+        Task(name, priority, stack_depth),
+        _backend(pin),
+        _min_interval(max_fps == 0 ? 0 : (CYCLES_PER_SECOND + max_fps - 1) / max_fps)
+    {
+        for(auto& frame: _frames) {
+            frame.fill(0);
+        }
+    }
+
+    UBaseType_t size() const
+    {
+        return length;
+    }
+
+    /** Color in back buffer */
+    inline __attribute__((always_inline))
+    LedColor& operator[](UBaseType_t idx)
+    {
+        return *reinterpret_cast<LedColor*>(reinterpret_cast<uint8_t*>(_frames[BACK].data()) + 3 * idx);
+    }
+
+    inline __attribute__((always_inline))
+    const LedColor operator[](UBaseType_t idx) const
+    {
+        return *reinterpret_cast<const LedColor*>(reinterpret_cast<const uint8_t*>(_frames[BACK].data()) + 3 * idx);
+    }
+
+    /** Back buffer colors as one span for effect kernels */
+    LedColor* colors()
+    {
+        return reinterpret_cast<LedColor*>(_frames[BACK].data());
+    }
+
+    void reset()
+    {
+        _frames[BACK].fill(0);
+    }
+
+    /** Colors are converted by stage before sending. Set nullptr to send them as is */
+    void SetOutputStage(LedOutputStage<length>* stage)
+    {
+        _stage = stage;
+    }
+
+    /** Publish back buffer. Frames committed faster than frame rate are merged */
+    void Commit()
+    {
+        {
+            Mutex::LockGuard lock(_mutex);
+            _frames[_pending] = _frames[BACK];
+            _is_pending = true;
+            _commits += 1;
+        }
+        if(_handle != nullptr) {
+            xTaskNotifyGive(_handle);
+        }
+    }
+
+    uint32_t commits() const
+    {
+        return _commits;
+    }
+
+    uint32_t frames_sent() const
+    {
+        return _sent;
+    }
+
+    /** Committed frames which were equal to the last sent one */
+    uint32_t frames_skipped() const
+    {
+        return _skipped;
+    }
+
+    /** Frames per second measured over the last second, in 0.1 FPS */
+    uint32_t fps_x10() const
+    {
+        return _fps_x10;
+    }
+
+    void run()
+    {
+        TickType_t fps_start = xTaskGetTickCount();
+        uint32_t fps_frames = 0;
+        for(;;) {
+            // dithering spreads error over next frames, so it must not freeze on still picture
+            const bool is_refresh = _stage != nullptr && _stage->dithering();
+            ulTaskNotifyTake(pdTRUE, is_refresh ? _RefreshTicks() : portMAX_DELAY);
+
+            // commits during this time are merged into one frame
+            for(uint32_t left = _IntervalLeft(); left != 0; left = _IntervalLeft()) {
+                // delay is rounded up and checked again, so frame rate doesn't exceed max_fps
+                vTaskDelay((left + CYCLES_PER_TICK - 1) / CYCLES_PER_TICK);
+            }
+            // on refresh front frame is sent again if there is no new one
+            if(!_TakeFrame() && !is_refresh) {
+                continue;
+            }
+
+            // usually the gap is already over, so it almost never spins
+            while(soc_get_ccount() - _last_ccount < RESET_CYCLES) {
+            }
+            uint32_t* frame = _frames[_front].data();
+            if(_stage != nullptr) {
+                frame = _stage->Apply(reinterpret_cast<const uint8_t*>(frame));
+            }
+            _backend.SendFrame(frame, _frames[_front].size());
+            _last_ccount = soc_get_ccount();
+            _last_tick = xTaskGetTickCount();
+            _sent += 1;
+
+            fps_frames += 1;
+            const TickType_t elapsed = _last_tick - fps_start;
+            if(elapsed >= pdMS_TO_TICKS(1000)) {
+                _fps_x10 = fps_frames * 10000 / (elapsed * portTICK_PERIOD_MS);
+                fps_frames = 0;
+                fps_start = _last_tick;
+            }
+        }
+    }
+
+private:
+    using Mutex = espp::Mutex<>;
+    using Frame = std::array<uint32_t, (3 * length + 3) / 4>;
+    static const std::size_t BACK = 0;
+    static const uint32_t CYCLES_PER_TICK = CYCLES_PER_SECOND / configTICK_RATE_HZ;
+
+    Backend _backend;
+    LedOutputStage<length>* _stage = nullptr;
+    const uint32_t _min_interval;     ///< in cycles
+    Mutex _mutex{"leds"};
+    /** Back buffer, pending committed frame and front (last sent) frame */
+    std::array<Frame, 3> _frames;
+    std::size_t _pending = 1;
+    std::size_t _front = 2;
+    /** Pending frame was committed after the last take. Notification can be left from merged commits */
+    bool _is_pending = false;
+
+    TickType_t _last_tick = 0;
+    uint32_t _last_ccount = 0;
+    uint32_t _commits = 0;
+    uint32_t _sent = 0;
+    uint32_t _skipped = 0;
+    uint32_t _fps_x10 = 0;
+
+    /** Cycles until frame rate allows the next frame */
+    uint32_t _IntervalLeft() const
+    {
+        // ccount wraps in tens of seconds, tick count shows that interval is long over
+        if(_sent == 0 || xTaskGetTickCount() - _last_tick > pdMS_TO_TICKS(1000)) {
+            return 0;
+        }
+        const uint32_t elapsed = soc_get_ccount() - _last_ccount;
+        return elapsed >= _min_interval ? 0 : _min_interval - elapsed;
+    }
+
+    /** Refresh period of dithering, at least one tick */
+    TickType_t _RefreshTicks() const
+    {
+        const TickType_t ticks = (_min_interval + CYCLES_PER_TICK - 1) / CYCLES_PER_TICK;
+        return ticks == 0 ? 1 : ticks;
+    }
+
+    /** Swap pending and front frames if pending is new and differs from the last sent */
+    bool _TakeFrame()
+    {
+        Mutex::LockGuard lock(_mutex);
+        if(!_is_pending) {
+            return false;
+        }
+        // after swap pending holds the old front frame, which mustn't be sent again
+        _is_pending = false;
+        // the first frame is always sent, LEDs can show anything after power up
+        if(_sent != 0 && std::memcmp(_frames[_pending].data(), _frames[_front].data(), sizeof(Frame)) == 0) {
+            _skipped += 1;
+            return false;
+        }
+        std::swap(_pending, _front);
+        return true;
+    }
+};
+
+}
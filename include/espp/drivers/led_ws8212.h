@@ -4,79 +4,73 @@
 
 #include "espp/gpio.h"
 #include "espp/utils/test.h"
+#include "espp/drivers/bit_transpose.h"
+#include "espp/drivers/led_color.h"
+#include "espp/drivers/led_output.h"
 
 #include <array>
 
 namespace espp {
 void IRAM_ATTR SendLed(uint32_t mask, uint32_t* buffer, uint32_t size);
 
-struct LedColor{
-    uint8_t green;
-    uint8_t red;
-    uint8_t blue;
-
-    LedColor():
-        green(0), red(0), blue(0)
-    {}
-
-    LedColor(uint8_t R, uint8_t G, uint8_t B):
-        green(G), red(R), blue(B)
-    {}
-
-    static
-    uint8_t _Truncate(int32_t c)
+/** Same as SendLed, but caller has to keep reset gap before the next frame */
+void IRAM_ATTR SendLedFrame(uint32_t mask, uint32_t* buffer, uint32_t size);
+
+/**
+ * Send up to 8 strips at once.
+ *
+ * Each byte of all strips is transposed into 8 bit planes just before it's sent (see Transpose8x8),
+ * which makes low level after every 8th bit about 0.3 us longer.
+ *
+ * @param mask pins of all strips
+ * @param lut GPIO mask of high pins for high nibble of plane (first 16) and low nibble (next 16)
+ * @param strips colors of each strip, size bytes each
+ */
+void IRAM_ATTR SendLedParallel(uint32_t mask, const uint32_t* lut, const uint8_t* const* strips, uint32_t count,
+                               uint32_t size);
+
+/**
+ * Bit-bang output. Interrupts are disabled while frame is sent and caller waits for reset time
+ */
+class LedBitBang{
+public:
+    explicit
+    LedBitBang(GpioPin& pin): _gpio_pin(pin)
     {
-        return std::max(std::min(c, 0xFF), 0);
     }
 
-    template<class T>
-    LedColor& operator=(const T& other)
+    void Send(uint32_t* buffer, UBaseType_t size)
     {
-        green = other.green;
-        red = other.red;
-        blue = other.blue;
-        return *this;
+        SendLed(_gpio_pin.mask(), buffer, size);
     }
-};
 
-inline
-LedColor operator*(const LedColor& color, uint32_t c)
-{
-    assert(c < 0xFFu);
-    return {
-        static_cast<uint8_t>(color.red * c / 0xFFu),
-        static_cast<uint8_t>(color.green * c / 0xFFu),
-        static_cast<uint8_t>(color.blue * c / 0xFFu)
-    };
-}
+    /** Send without waiting for reset */
+    void SendFrame(uint32_t* buffer, UBaseType_t size)
+    {
+        SendLedFrame(_gpio_pin.mask(), buffer, size);
+    }
 
-inline
-LedColor operator*(uint32_t c, const LedColor& color)
-{
-    return (color * c);
-}
+    const GpioPin& pin() const
+    {
+        return _gpio_pin;
+    }
 
-inline
-LedColor operator+(const LedColor& color, int32_t c)
-{
-    return {
-        LedColor::_Truncate(color.red + c),
-        LedColor::_Truncate(color.green + c),
-        LedColor::_Truncate(color.blue + c),
-    };
-}
+private:
+    GpioPin _gpio_pin;
+};
 
-inline
-LedColor operator-(const LedColor& color, int32_t c)
-{
-    return color + (-c);
-}
+template<std::size_t length, std::size_t count>
+class LedStripGroup;
 
-template<std::size_t length>
+/**
+ * @tparam length number of LEDs
+ * @tparam Backend output with constructor from GpioPin and method Send(uint32_t* buffer, UBaseType_t size)
+ */
+template<std::size_t length, class Backend = LedBitBang>
 class LedStrip{
 public:
     explicit
-    LedStrip(GpioPin& pin): _gpio_pin(pin), _buffer(), _colors(reinterpret_cast<uint8_t*>(_buffer.data()))
+    LedStrip(GpioPin& pin): _backend(pin), _buffer(), _colors(reinterpret_cast<uint8_t*>(_buffer.data()))
     {
         reset();
     }
@@ -98,6 +92,12 @@ public:
         return *reinterpret_cast<const LedColor*>(_colors + 3 * idx);
     }
 
+    /** All colors as one span for effect kernels (see led_effects.h) */
+    LedColor* colors()
+    {
+        return reinterpret_cast<LedColor*>(_colors);
+    }
+
     void reset()
     {
         _buffer.fill(0);
@@ -105,13 +105,22 @@ public:
 
     void send()
     {
-        SendLed(_gpio_pin.mask(), ledBuffer(), ledBufferSize());
+        _backend.Send(ledBuffer(), ledBufferSize());
+    }
+
+    /** Send colors converted by output stage. Strip buffer keeps original colors */
+    void send(LedOutputStage<length>& stage)
+    {
+        _backend.Send(stage.Apply(_colors), ledBufferSize());
     }
 
 
 private:
+    template<std::size_t, std::size_t>
+    friend class LedStripGroup;
+
     const static std::size_t _bufferSize = (3 * length + 3) / 4;
-    GpioPin _gpio_pin;
+    Backend _backend;
     std::array<uint32_t, _bufferSize> _buffer;
     uint8_t* const _colors;
 
@@ -127,12 +136,78 @@ private:
 
 };
 
+/**
+ * Up to 8 bit-bang strips of same length sent in one transmission.
+ *
+ * Bytes of all strips are transposed into bit planes, so every bit of all strips is one
+ * out_w1ts, one out_w1tc for zero bits and one out_w1tc for all pins.
+ * Planes are made on the fly, so group adds only 128 bytes of pin masks to strips.
+ * Interrupts are disabled for the time of one strip.
+ */
+template<std::size_t length, std::size_t count>
+class LedStripGroup{
+public:
+    static_assert(count > 0 && count <= 8, "group supports up to 8 strips");
+
+    using Strip = LedStrip<length>;
+
+    explicit
+    LedStripGroup(const std::array<Strip*, count>& strips):
+        _strips(strips)
+    {
+        std::array<uint32_t, count> masks;
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            masks[idx] = _strips[idx]->_backend.pin().mask();
+            _mask |= masks[idx];
+        }
+        for(uint32_t nibble = 0; nibble < 16; ++nibble) {
+            uint32_t high = 0;
+            uint32_t low = 0;
+            for(std::size_t idx = 0; idx < count; ++idx) {
+                // strip idx is bit (7 - idx) of plane
+                if(idx < 4 && (nibble & (0x8u >> idx)) != 0) {
+                    high |= masks[idx];
+                }
+                if(idx >= 4 && (nibble & (0x8u >> (idx - 4))) != 0) {
+                    low |= masks[idx];
+                }
+            }
+            _lut[nibble] = high;
+            _lut[16 + nibble] = low;
+        }
+    }
+
+    Strip& operator[](std::size_t idx)
+    {
+        return *_strips[idx];
+    }
+
+    void send()
+    {
+        std::array<const uint8_t*, count> colors;
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            colors[idx] = _strips[idx]->_colors;
+        }
+        SendLedParallel(_mask, _lut.data(), colors.data(), count, _bytes);
+    }
+
+private:
+    static const std::size_t _bytes = 4 * Strip::_bufferSize;
+
+    const std::array<Strip*, count> _strips;
+    uint32_t _mask = 0;
+    std::array<uint32_t, 32> _lut;
+};
+
 #ifdef ENABLE_TEST
     namespace testing {
         void testWaitConstResult(uint32_t constDelays[20]);
         void testWaitVarResult(uint32_t vars[20]);
         uint32_t testPut32BitsResult();
         uint32_t testSendDataResult();
+        uint32_t testSendParallelResult();
+        uint32_t testOutputStageResult();
+        uint32_t testRainbowResult();
     }
 #endif
 
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include "espp/gpio.h"
+
+namespace espp {
+
+/**
+ * I2S DMA output for LedStrip.
+ *
+ * Frame is encoded by Ws2812I2sEncoder in small chunks and copied to DMA buffers,
+ * so interrupts stay enabled and Send returns as soon as frame is queued.
+ * Zero samples are appended as reset. Idle line is low due to tx_desc_auto_clear.
+ * I2S data output is fixed to GPIO3 (RX), and there is only one I2S.
+ *
+ * By default DMA buffers are sized by the first frame, so whole frame fits and Send doesn't block.
+ * It costs 12 bytes of DMA memory per LED (4 KB for 300 LEDs). With fixed number of buffers
+ * Send blocks until the part of frame above (dma_buffers - 1) * DMA_BUFFER_LENGTH samples
+ * is sent, e.g. about 5 ms for 300 LEDs and 8 buffers.
+ */
+class LedI2s{
+public:
+    /** Number of DMA buffers is chosen by the first frame */
+    static const std::size_t AUTO_DMA_BUFFERS = 0;
+    /** Limits of I2S driver */
+    static const std::size_t MIN_DMA_BUFFERS = 2;
+    static const std::size_t MAX_DMA_BUFFERS = 128;
+    /** Samples per DMA buffer. One sample is one LED byte */
+    static const std::size_t DMA_BUFFER_LENGTH = 64;
+    /** 300 us of low level */
+    static const std::size_t RESET_SAMPLES = 30;
+
+    /** @param pin must be GPIO3 */
+    explicit
+    LedI2s(GpioPin& pin, std::size_t dma_buffers = AUTO_DMA_BUFFERS);
+
+    ~LedI2s();
+
+    LedI2s(const LedI2s&) = delete;
+
+    void Send(uint32_t* buffer, UBaseType_t size);
+
+    /** Reset samples are always queued after frame, so it's same as Send */
+    void SendFrame(uint32_t* buffer, UBaseType_t size)
+    {
+        Send(buffer, size);
+    }
+
+    std::size_t dma_buffers() const
+    {
+        return _dma_buffers;
+    }
+
+private:
+    std::size_t _dma_buffers;
+    bool _is_installed = false;
+
+    /** @param samples frame length, used only with AUTO_DMA_BUFFERS */
+    bool _Install(std::size_t samples);
+};
+
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace espp {
+
+/**
+ * Encoder of WS2812 bits into I2S symbols.
+ *
+ * Each data bit is 4 I2S bits at 3.2 Mbps (312.5 ns): 0 -> 1000, 1 -> 1110.
+ * So one data byte is one 32 bit I2S sample (16 bit stereo at 100 kHz).
+ * I2S sends the high half word first, so the high nibble goes to the high half word.
+ */
+class Ws2812I2sEncoder {
+public:
+    static const uint32_t SAMPLE_RATE = 100000;
+    static const uint32_t ZERO_SYMBOL = 0x8;
+    static const uint32_t ONE_SYMBOL = 0xE;
+
+    static inline
+    uint32_t Encode(uint8_t value)
+    {
+        return (static_cast<uint32_t>(_Nibble(value >> 4)) << 16) | _Nibble(value & 0xF);
+    }
+
+    /** Encode count bytes into count words */
+    static inline
+    void Encode(const uint8_t* data, std::size_t count, uint32_t* out)
+    {
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            out[idx] = Encode(data[idx]);
+        }
+    }
+
+private:
+    static inline
+    uint16_t _Nibble(uint8_t nibble)
+    {
+        // constant initialized, so there is no guard
+        static const uint16_t lut[16] = {
+            0x8888, 0x888E, 0x88E8, 0x88EE, 0x8E88, 0x8E8E, 0x8EE8, 0x8EEE,
+            0xE888, 0xE88E, 0xE8E8, 0xE8EE, 0xEE88, 0xEE8E, 0xEEE8, 0xEEEE,
+        };
+        return lut[nibble];
+    }
+};
+
+}
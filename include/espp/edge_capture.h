@@ -0,0 +1,85 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include <array>
+
+#include "espp/gpio.h"
+#include "espp/pulse_decoder.h"
+#include "espp/ring_queue.h"
+
+namespace espp {
+
+/**
+ * Capture of GPIO edges for pulse measurement.
+ *
+ * ISR only reads cycle counter and level and pushes Edge into ring buffer.
+ * Consumer task reads edges and feeds decoders from pulse_decoder.h.
+ */
+class EdgeCapture {
+public:
+    static const std::size_t CAPACITY = 128;
+
+    struct Stats {
+        uint32_t edges;             ///< captured edges
+        uint32_t overflows;         ///< edges lost because buffer was full
+        uint32_t missed;            ///< ISR saw same level twice, so pulse was shorter than ISR latency
+        uint32_t max_isr_cycles;    ///< the longest ISR
+        uint32_t min_interval;      ///< the shortest time between two ISR calls
+    };
+
+    EdgeCapture():
+        _slots()
+    {
+        ResetStats();
+    }
+
+    EdgeCapture(const EdgeCapture&) = delete;
+
+    /** Capture any edge of pin. ISR service has to be installed */
+    bool Add(GpioPin& pin);
+
+    void Remove(GpioPin& pin);
+
+    /** Return number of read edges */
+    std::size_t Read(Edge* edges, std::size_t count)
+    {
+        return _queue.Pop(edges, count);
+    }
+
+    /** Wait until buffer has edges. Only one task can wait */
+    bool Wait(TickType_t ticks = portMAX_DELAY)
+    {
+        return _queue.Wait(ticks);
+    }
+
+    /** Statistic is updated by ISR, so it can be inconsistent */
+    const Stats& stats() const
+    {
+        return _stats;
+    }
+
+    void ResetStats();
+
+private:
+    struct Slot {
+        EdgeCapture* capture;
+        uint8_t level;
+    };
+
+    std::array<Slot, GPIO_NUM_MAX> _slots;
+    SpscQueue<Edge, CAPACITY> _queue;
+    Stats _stats;
+    uint32_t _last_isr = 0;
+
+    static
+    void _Isr(void* arg);
+};
+
+inline const Log& operator<<(const Log& log, const EdgeCapture::Stats& stats)
+{
+    return log << "edges" << stats.edges << "overflows" << stats.overflows << "missed" << stats.missed
+               << "max ISR cycles" << stats.max_isr_cycles << "min interval" << stats.min_interval;
+}
+
+}
@@ -0,0 +1,397 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+
+#include "esp8266/eagle_soc.h"
+
+#include <array>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "espp/critical_section.h"
+#include "espp/task.h"
+#include "espp/utils/macros.h"
+
+namespace espp {
+
+/**
+ * Callable stored inside object without heap.
+ *
+ * @tparam size max size of callable (lambda captures)
+ */
+template<std::size_t size>
+class InplaceFunction {
+public:
+    InplaceFunction() = default;
+
+    template<class F>
+    InplaceFunction(F f)
+    {
+        static_assert(sizeof(F) <= size, "callable is too big");
+        static_assert(alignof(F) <= alignof(Storage), "callable has unsupported alignment");
+        new(&_storage) F(std::move(f));
+        _invoke = &_Invoke<F>;
+        _destroy = &_Destroy<F>;
+        _move = &_Move<F>;
+    }
+
+    InplaceFunction(InplaceFunction&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+
+    ~InplaceFunction()
+    {
+        Reset();
+    }
+
+    InplaceFunction& operator=(InplaceFunction&& other) noexcept
+    {
+        if(this != &other) {
+            Reset();
+            if(other._invoke != nullptr) {
+                other._move(&_storage, &other._storage);
+                _invoke = other._invoke;
+                _destroy = other._destroy;
+                _move = other._move;
+                other.Reset();
+            }
+        }
+        return *this;
+    }
+
+    explicit operator bool() const
+    {
+        return _invoke != nullptr;
+    }
+
+    void operator()()
+    {
+        _invoke(&_storage);
+    }
+
+    void Reset()
+    {
+        if(_invoke != nullptr) {
+            _destroy(&_storage);
+            _invoke = nullptr;
+        }
+    }
+
+private:
+    using Storage = typename std::aligned_storage<size, alignof(void*)>::type;
+
+    Storage _storage;
+    void (*_invoke)(void*) = nullptr;
+    void (*_destroy)(void*) = nullptr;
+    void (*_move)(void*, void*) = nullptr;
+
+    template<class F>
+    static void _Invoke(void* f)
+    {
+        (*reinterpret_cast<F*>(f))();
+    }
+
+    template<class F>
+    static void _Destroy(void* f)
+    {
+        reinterpret_cast<F*>(f)->~F();
+    }
+
+    template<class F>
+    static void _Move(void* to, void* from)
+    {
+        new(to) F(std::move(*reinterpret_cast<F*>(from)));
+    }
+};
+
+struct ExecutorStats {
+    unsigned int posted = 0;
+    unsigned int executed = 0;
+    unsigned int dropped = 0;
+    unsigned int depth = 0;
+    unsigned int max_depth = 0;
+    uint32_t max_latency_cycles = 0;     ///< from job is ready until it is started
+    uint32_t total_latency_cycles = 0;   ///< reset by ResetStats. Can overflow
+
+    uint32_t avg_latency_cycles() const
+    {
+        return executed == 0 ? 0 : total_latency_cycles / executed;
+    }
+};
+
+inline
+const Log& operator<<(const Log& log, const ExecutorStats& stats)
+{
+    return log << "posted" << stats.posted << "executed" << stats.executed << "dropped" << stats.dropped
+               << "depth" << stats.depth << "max depth" << stats.max_depth
+               << "latency avg" << stats.avg_latency_cycles() << "max" << stats.max_latency_cycles;
+}
+
+/**
+ * Run small jobs on few worker tasks instead of dedicated task per activity.
+ *
+ * Jobs are stored in fixed slots without heap. Ready jobs are executed by
+ * priority (higher first) and in post order for same priority.
+ *
+ * @tparam capacity max number of pending jobs
+ * @tparam jobSize max size of job callable
+ * @tparam workers number of worker tasks
+ */
+template<std::size_t capacity, std::size_t jobSize = 16, std::size_t workers = 1>
+class Executor {
+public:
+    using Job = InplaceFunction<jobSize>;
+
+    explicit
+    Executor(const char* name = "executor", UBaseType_t priority = 1,
+             configSTACK_DEPTH_TYPE stack_depth = Task::DEFAULT_STACK_DEPTH):
+        _signal(xSemaphoreCreateCounting(capacity, 0))
+    {
+        static_assert(capacity > 0 && capacity < 0xFFFF, "invalid capacity");
+        ESPP_CHECK(_signal != nullptr);
+        for(std::size_t idx = 0; idx < capacity; ++idx) {
+            _free[idx] = static_cast<uint16_t>(idx);
+        }
+        _free_count = capacity;
+        for(auto& worker: _workers) {
+            worker._Init(this, name, priority, stack_depth);
+        }
+    }
+
+    Executor(const Executor&) = delete;
+
+    bool Start()
+    {
+        bool result = true;
+        for(auto& worker: _workers) {
+            result = Task::Start(worker) && result;
+        }
+        return result;
+    }
+
+    bool Post(Job job, uint8_t priority = 0)
+    {
+        if(!_Push(std::move(job), priority, 0)) {
+            return false;
+        }
+        xSemaphoreGive(_signal);
+        return true;
+    }
+
+    bool PostDelayed(Job job, uint32_t delay_ms, uint8_t priority = 0)
+    {
+        if(!_Push(std::move(job), priority, pdMS_TO_TICKS(delay_ms))) {
+            return false;
+        }
+        xSemaphoreGive(_signal);
+        return true;
+    }
+
+    /** Job is stored without heap, so it can be posted from ISR */
+    bool PostFromISR(Job job, uint8_t priority = 0)
+    {
+        if(!_Push(std::move(job), priority, 0, true)) {
+            return false;
+        }
+        BaseType_t woken = pdFALSE;
+        xSemaphoreGiveFromISR(_signal, &woken);
+        if(woken == pdTRUE) {
+            portYIELD_FROM_ISR();
+        }
+        return true;
+    }
+
+    ExecutorStats stats() const
+    {
+        CriticalSection lock;
+        return _stats;
+    }
+
+    void ResetStats()
+    {
+        CriticalSection lock;
+        const auto depth = _stats.depth;
+        _stats = {};
+        _stats.depth = depth;
+        _stats.max_depth = depth;
+    }
+
+private:
+    struct Slot {
+        Job job;
+        TickType_t due;
+        uint32_t ready_cycles;
+        uint32_t sequence;
+        uint8_t priority;
+    };
+
+    class Worker: public Task {
+    public:
+        Worker():
+            Task(nullptr, 0)
+        {
+        }
+
+        void run()
+        {
+            _executor->_Run();
+        }
+
+    private:
+        friend class Executor;
+        Executor* _executor = nullptr;
+
+        void _Init(Executor* executor, const char* name, UBaseType_t priority, configSTACK_DEPTH_TYPE stack_depth)
+        {
+            _executor = executor;
+            _name = name;
+            _priority = priority;
+            _stack_depth = stack_depth;
+        }
+    };
+
+    const SemaphoreHandle_t _signal;
+    std::array<Slot, capacity> _slots;
+    std::array<uint16_t, capacity> _free;
+    std::array<uint16_t, capacity> _ready;
+    std::array<uint16_t, capacity> _delayed;
+    std::size_t _free_count = 0;
+    std::size_t _ready_count = 0;
+    std::size_t _delayed_count = 0;
+    uint32_t _sequence = 0;
+    ExecutorStats _stats;
+    std::array<Worker, workers> _workers;
+
+    /** true if slot a has to run before slot b */
+    bool _IsReadyBefore(uint16_t a, uint16_t b) const
+    {
+        const Slot& sa = _slots[a];
+        const Slot& sb = _slots[b];
+        if(sa.priority != sb.priority) {
+            return sa.priority > sb.priority;
+        }
+        return static_cast<int32_t>(sa.sequence - sb.sequence) < 0;
+    }
+
+    bool _IsDueBefore(uint16_t a, uint16_t b) const
+    {
+        return static_cast<int32_t>(_slots[a].due - _slots[b].due) < 0;
+    }
+
+    template<class Less>
+    void _HeapPush(std::array<uint16_t, capacity>& heap, std::size_t& count, uint16_t slot, Less less)
+    {
+        std::size_t idx = count++;
+        while(idx > 0) {
+            const std::size_t parent = (idx - 1) / 2;
+            if(!less(slot, heap[parent])) {
+                break;
+            }
+            heap[idx] = heap[parent];
+            idx = parent;
+        }
+        heap[idx] = slot;
+    }
+
+    template<class Less>
+    uint16_t _HeapPop(std::array<uint16_t, capacity>& heap, std::size_t& count, Less less)
+    {
+        const uint16_t result = heap[0];
+        const uint16_t last = heap[--count];
+        std::size_t idx = 0;
+        for(;;) {
+            std::size_t child = 2 * idx + 1;
+            if(child >= count) {
+                break;
+            }
+            if(child + 1 < count && less(heap[child + 1], heap[child])) {
+                child += 1;
+            }
+            if(!less(heap[child], last)) {
+                break;
+            }
+            heap[idx] = heap[child];
+            idx = child;
+        }
+        heap[idx] = last;
+        return result;
+    }
+
+    bool _Push(Job&& job, uint8_t priority, TickType_t delay, bool from_isr = false)
+    {
+        ESPP_ASSERT(static_cast<bool>(job));
+        const TickType_t now = from_isr ? xTaskGetTickCountFromISR() : xTaskGetTickCount();
+        CriticalSection lock;
+        if(_free_count == 0) {
+            _stats.dropped += 1;
+            return false;
+        }
+        const uint16_t slot_idx = _free[--_free_count];
+        Slot& slot = _slots[slot_idx];
+        slot.job = std::move(job);
+        slot.priority = priority;
+        slot.due = now + delay;
+        slot.sequence = _sequence++;
+        slot.ready_cycles = soc_get_ccount();
+        if(delay == 0) {
+            _HeapPush(_ready, _ready_count, slot_idx, [this](uint16_t a, uint16_t b) { return _IsReadyBefore(a, b); });
+        } else {
+            _HeapPush(_delayed, _delayed_count, slot_idx, [this](uint16_t a, uint16_t b) { return _IsDueBefore(a, b); });
+        }
+        _stats.posted += 1;
+        _stats.depth += 1;
+        if(_stats.depth > _stats.max_depth) {
+            _stats.max_depth = _stats.depth;
+        }
+        return true;
+    }
+
+    /** Take next ready job or return time to wait */
+    bool _Pop(Job& job, TickType_t& wait)
+    {
+        const TickType_t now = xTaskGetTickCount();
+        CriticalSection lock;
+        while(_delayed_count > 0 && static_cast<int32_t>(_slots[_delayed[0]].due - now) <= 0) {
+            const auto slot_idx = _HeapPop(_delayed, _delayed_count, [this](uint16_t a, uint16_t b) { return _IsDueBefore(a, b); });
+            _slots[slot_idx].ready_cycles = soc_get_ccount();
+            _HeapPush(_ready, _ready_count, slot_idx, [this](uint16_t a, uint16_t b) { return _IsReadyBefore(a, b); });
+        }
+        if(_ready_count == 0) {
+            wait = _delayed_count == 0 ? portMAX_DELAY : _slots[_delayed[0]].due - now;
+            return false;
+        }
+        const auto slot_idx = _HeapPop(_ready, _ready_count, [this](uint16_t a, uint16_t b) { return _IsReadyBefore(a, b); });
+        Slot& slot = _slots[slot_idx];
+        job = std::move(slot.job);
+        const uint32_t latency = soc_get_ccount() - slot.ready_cycles;
+        _free[_free_count++] = slot_idx;
+        _stats.executed += 1;
+        _stats.depth -= 1;
+        _stats.total_latency_cycles += latency;
+        if(latency > _stats.max_latency_cycles) {
+            _stats.max_latency_cycles = latency;
+        }
+        return true;
+    }
+
+    void _Run()
+    {
+        Job job;
+        for(;;) {
+            TickType_t wait;
+            if(_Pop(job, wait)) {
+                job();
+                job.Reset();
+            } else {
+                xSemaphoreTake(_signal, wait);
+            }
+        }
+    }
+};
+
+}
@@ -6,6 +6,7 @@
 #include "driver/gpio.h"
 
 #include "espp/log.h"
+#include "espp/utils/test.h"
 
 namespace espp {
 
@@ -100,6 +101,290 @@ public:
     }
 };
 
+/**
+ * GPIO pin known at compile time.
+ *
+ * Mask is constant and level is read directly from GPIO.in, so each operation is one load or store.
+ *
+ * @tparam num pin number (GPIO16 is RTC pin and isn't supported)
+ */
+template<gpio_num_t num>
+class GpioFixedPin {
+public:
+    static_assert(num >= GPIO_NUM_0 && num < GPIO_NUM_16, "only digital GPIO is supported");
+
+    static constexpr gpio_num_t PIN = num;
+    static constexpr uint32_t MASK = 0x1u << num;
+
+    static
+    gpio_num_t pin()
+    {
+        return PIN;
+    }
+
+    static
+    uint32_t mask()
+    {
+        return MASK;
+    }
+
+    static inline
+    bool HasLowLevel() __attribute__((always_inline))
+    {
+        return (GPIO.in & MASK) == 0;
+    }
+
+    static inline
+    bool HasHighLevel() __attribute__((always_inline))
+    {
+        return !HasLowLevel();
+    }
+
+    static inline
+    void SetLowLevel() __attribute__((always_inline))
+    {
+        GPIO.out_w1tc = MASK;
+    }
+
+    static inline
+    void SetHighLevel() __attribute__((always_inline))
+    {
+        GPIO.out_w1ts = MASK;
+    }
+
+    static
+    void Disable()
+    {
+        gpio_set_direction(PIN, GPIO_MODE_DISABLE);
+    }
+
+    static
+    void EnableInput()
+    {
+        gpio_set_direction(PIN, GPIO_MODE_INPUT);
+    }
+
+    static
+    void EnableOutput()
+    {
+        gpio_set_direction(PIN, GPIO_MODE_OUTPUT);
+    }
+
+    static
+    void EnablePullUpOnly()
+    {
+        gpio_set_pull_mode(PIN, GPIO_PULLUP_ONLY);
+    }
+
+    static
+    void EnablePullDownOnly()
+    {
+        gpio_set_pull_mode(PIN, GPIO_PULLDOWN_ONLY);
+    }
+
+    static
+    GpioState state()
+    {
+        return {.pin = PIN, .level = HasLowLevel() ? 'L' : 'H'};
+    }
+};
+
+/**
+ * Masks of GpioPort pins
+ */
+template<class... Pins>
+struct GpioPortMask;
+
+template<>
+struct GpioPortMask<> {
+    static constexpr uint32_t value = 0;
+
+    static inline
+    uint32_t Spread(uint32_t)
+    {
+        return 0;
+    }
+
+    static inline
+    uint32_t Gather(uint32_t)
+    {
+        return 0;
+    }
+};
+
+template<class Pin, class... Pins>
+struct GpioPortMask<Pin, Pins...> {
+    static_assert((Pin::MASK & GpioPortMask<Pins...>::value) == 0, "pin is used twice");
+
+    static constexpr uint32_t value = Pin::MASK | GpioPortMask<Pins...>::value;
+
+    /** Bit i of value to mask of pin i */
+    static inline
+    uint32_t Spread(uint32_t bits)
+    {
+        return ((bits & 0x1u) != 0 ? Pin::MASK : 0) | GpioPortMask<Pins...>::Spread(bits >> 1);
+    }
+
+    /** Level of pin i to bit i */
+    static inline
+    uint32_t Gather(uint32_t levels)
+    {
+        return ((levels & Pin::MASK) != 0 ? 0x1u : 0) | (GpioPortMask<Pins...>::Gather(levels) << 1);
+    }
+};
+
+/**
+ * Group of GpioFixedPin which are changed together.
+ *
+ * Any combination of levels is set by one out_w1ts and one out_w1tc store.
+ *
+ * @tparam Pins GpioFixedPin types. Bit i of value is level of i-th pin
+ */
+template<class... Pins>
+class GpioPort {
+public:
+    static constexpr uint32_t MASK = GpioPortMask<Pins...>::value;
+    static constexpr std::size_t SIZE = sizeof...(Pins);
+
+    /** GPIO mask of pins which have to be high for value */
+    static inline
+    uint32_t HighMask(uint32_t value)
+    {
+        return GpioPortMask<Pins...>::Spread(value);
+    }
+
+    static inline
+    uint32_t Read() __attribute__((always_inline))
+    {
+        return GpioPortMask<Pins...>::Gather(GPIO.in);
+    }
+
+    static inline
+    void SetHighLevel() __attribute__((always_inline))
+    {
+        GPIO.out_w1ts = MASK;
+    }
+
+    static inline
+    void SetLowLevel() __attribute__((always_inline))
+    {
+        GPIO.out_w1tc = MASK;
+    }
+
+    static inline
+    void Write(uint32_t value) __attribute__((always_inline))
+    {
+        WriteMask(HighMask(value));
+    }
+
+    /** Write levels prepared by HighMask. It's the fastest way for precalculated data */
+    static inline
+    void WriteMask(uint32_t high_mask) __attribute__((always_inline))
+    {
+        GPIO.out_w1ts = high_mask;
+        GPIO.out_w1tc = MASK & ~high_mask;
+    }
+
+    static
+    void EnableOutput()
+    {
+        _ForEach<Pins...>::EnableOutput();
+    }
+
+    static
+    void EnableInput()
+    {
+        _ForEach<Pins...>::EnableInput();
+    }
+
+private:
+    template<class... Rest>
+    struct _ForEach {
+        static void EnableOutput() {}
+
+        static void EnableInput() {}
+    };
+
+    template<class Pin, class... Rest>
+    struct _ForEach<Pin, Rest...> {
+        static void EnableOutput()
+        {
+            Pin::EnableOutput();
+            _ForEach<Rest...>::EnableOutput();
+        }
+
+        static void EnableInput()
+        {
+            Pin::EnableInput();
+            _ForEach<Rest...>::EnableInput();
+        }
+    };
+};
+
+/**
+ * Accumulate levels of several pins or ports and apply them by two stores.
+ *
+ * Pins which are both set and cleared get the last written level.
+ */
+class GpioWriteBatch {
+public:
+    void SetHigh(uint32_t mask)
+    {
+        _high |= mask;
+        _low &= ~mask;
+    }
+
+    void SetLow(uint32_t mask)
+    {
+        _low |= mask;
+        _high &= ~mask;
+    }
+
+    template<class Port>
+    void Write(uint32_t value)
+    {
+        const uint32_t high = Port::HighMask(value);
+        SetHigh(high);
+        SetLow(Port::MASK & ~high);
+    }
+
+    void Merge(const GpioWriteBatch& other)
+    {
+        SetHigh(other._high);
+        SetLow(other._low);
+    }
+
+    void Apply() const __attribute__((always_inline))
+    {
+        GPIO.out_w1ts = _high;
+        GPIO.out_w1tc = _low;
+    }
+
+    uint32_t high() const
+    {
+        return _high;
+    }
+
+    uint32_t low() const
+    {
+        return _low;
+    }
+
+private:
+    uint32_t _high = 0;
+    uint32_t _low = 0;
+};
+
+#ifdef ENABLE_TEST
+namespace testing {
+    uint32_t testGpioPinReadResult();
+    uint32_t testGpioFixedPinReadResult();
+    uint32_t testGpioFixedPinSetResult();
+    uint32_t testGpioPortWriteResult();
+    uint32_t testGpioWriteBatchResult();
+}
+#endif
+
 /**
  * Base class for interruption
  */
@@ -142,7 +427,7 @@ public:
 
     ~GpioInterruptRegister()
     {
-        if(_registered || autoReg) {
+        if(_registered) {
             Unregister();
         }
     }
@@ -150,13 +435,17 @@ public:
     void Register()
     {
         assert(!_registered);
-        gpio_isr_handler_add(_handler.pin(), GpioInterruptRegister::handler, reinterpret_cast<void*>(&_handler));
+        ESP_ERROR_CHECK(gpio_set_intr_type(_handler.pin().pin(), intType));
+        ESP_ERROR_CHECK(gpio_isr_handler_add(_handler.pin().pin(), GpioInterruptRegister::handler,
+                                             reinterpret_cast<void*>(&_handler)));
+        _registered = true;
     }
 
     void Unregister()
     {
         assert(_registered);
-        gpio_isr_handler_remove(_handler.pin());
+        gpio_isr_handler_remove(_handler.pin().pin());
+        _registered = false;
     }
 
     static void handler(void* arg)
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+
+#include "espp/gpio.h"
+#include "espp/ring_queue.h"
+#include "espp/task.h"
+
+namespace espp {
+
+/**
+ * Edge captured by ISR front half
+ */
+struct GpioEvent {
+    uint32_t ccount;    ///< cycle count at interrupt
+    uint8_t pin;
+    uint8_t level;
+};
+
+/**
+ * Handler of deferred GPIO interrupt. Called in dispatcher task, so it doesn't have to be ISR safe.
+ */
+class GpioEventHandler {
+public:
+    /**
+     * @param event the last edge of collapsed burst
+     * @param edges number of edges collapsed into this event
+     */
+    virtual void OnGpioEvent(const GpioEvent& event, unsigned int edges) = 0;
+};
+
+/**
+ * Deferred GPIO interrupt dispatch.
+ *
+ * ISR only timestamps edge and pushes it into lock-free queue.
+ * Task collapses edges of one pin until it is quiet for debounce time and calls handler once.
+ * With any edge interrupt, a burst which returns pin to previous level is dropped as glitch.
+ */
+class GpioDispatcher: public Task {
+public:
+    static const std::size_t QUEUE_SIZE = 32;
+
+    explicit
+    GpioDispatcher(const char* name = "gpio", UBaseType_t priority = 5,
+                   configSTACK_DEPTH_TYPE stack_depth = 2048):
+        Task(name, priority, stack_depth),
+        _pins()
+    {
+    }
+
+    /**
+     * Set interrupt type and add ISR of pin. ISR service has to be installed.
+     *
+     * @param debounce_ms quiet time before event is delivered. 0 delivers each batch immediately
+     */
+    bool Add(GpioPin& pin, gpio_int_type_t type, GpioEventHandler& handler, uint32_t debounce_ms = 0);
+
+    /** Drop pending edges of pin. Handler can still be running in dispatcher task when Remove returns */
+    void Remove(GpioPin& pin);
+
+    /** Edges lost because queue was full */
+    unsigned int dropped() const
+    {
+        return _queue.dropped();
+    }
+
+    /** Bursts dropped by glitch filter */
+    unsigned int glitches() const
+    {
+        return _glitches;
+    }
+
+    void run();
+
+private:
+    struct PinSlot {
+        GpioDispatcher* dispatcher;
+        GpioEventHandler* handler;
+        TickType_t debounce;
+        TickType_t settle_tick;
+        GpioEvent last;
+        uint16_t edges;
+        uint8_t stable_level;
+        bool glitch_filter;
+    };
+
+    std::array<PinSlot, GPIO_NUM_MAX> _pins;
+    MpscQueue<GpioEvent, QUEUE_SIZE> _queue;
+    unsigned int _glitches = 0;
+
+    static
+    void _Isr(void* arg);
+
+    /** Called in critical section, slots are shared with Add and Remove */
+    void _OnEdge(const GpioEvent& event, TickType_t now);
+
+    /** Deliver settled bursts. Return ticks to the next settle time */
+    TickType_t _Settle(TickType_t now);
+};
+
+}
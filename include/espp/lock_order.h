@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstdint>
+
+namespace espp {
+
+/**
+ * Debug checker of lock order.
+ *
+ * Enabled by ESPP_LOCK_ORDER_CHECK, which has to be defined for whole build since it adds
+ * LTS::LOCK_ORDER slot. Only named locks are registered, the first MAX_LOCKS
+ * of them get an id. Every acquire of a registered lock adds edges
+ * "held lock -> acquired lock" into global graph. Locks held by task are kept as bit mask in LTS.
+ * If acquired lock can already reach one of held locks, order is inverted and cycle is reported
+ * once per pair, before tasks really deadlock.
+ *
+ * Also measures critical sections and remembers the longest one.
+ */
+class LockOrder {
+public:
+    static const uint8_t MAX_LOCKS = 32;
+    /** Id of lock which isn't checked (unnamed or table is full) */
+    static const uint8_t NO_ID = MAX_LOCKS;
+
+    /** Critical section longer than this number of cycles is counted as too long */
+#ifdef ESPP_CRITICAL_SECTION_MAX_CYCLES
+    static const uint32_t CRITICAL_SECTION_MAX_CYCLES = ESPP_CRITICAL_SECTION_MAX_CYCLES;
+#else
+    static const uint32_t CRITICAL_SECTION_MAX_CYCLES = 16000;
+#endif
+
+    /** Return NO_ID for unnamed lock, so it doesn't take place in table */
+    static
+    uint8_t Register(const char* name);
+
+    /** Check order and mark lock as held by current task */
+    static
+    void OnAcquire(uint8_t id);
+
+    static
+    void OnRelease(uint8_t id);
+
+    /** Called by CriticalSection. Must be called with interrupts disabled */
+    static
+    void OnCriticalEnter();
+
+    static
+    void OnCriticalExit(const char* function);
+
+    /** Log lock graph and critical section statistic */
+    static
+    void Dump();
+
+private:
+    static
+    const char* _Name(uint8_t id);
+
+    static
+    void _Report(uint8_t held, uint8_t id);
+};
+
+}
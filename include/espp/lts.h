@@ -15,7 +15,10 @@ enum class LTS{
     USER,
     USER_0 = USER,
     USER_1,
-    USER_2
+    USER_2,
+#ifdef ESPP_LOCK_ORDER_CHECK
+    LOCK_ORDER,     ///< locks held by task, used by LockOrder. After USER slots, so they keep indexes
+#endif
 };
 
 /**
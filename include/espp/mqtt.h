@@ -9,6 +9,7 @@
 #include "espp/mutex.h"
 #include "espp/task.h"
 
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
@@ -46,14 +47,17 @@ public:
 
     bool isConnected() const
     {
-        return _is_connected;
+        return _is_connected.load();
     }
 
     bool Publish(const char* topic, const char* data, std::size_t data_len, bool retain = false)
     {
         DEBUG << "Publish message to" << topic << "retain" << retain;
-        ESPP_ASSERT(data_len > 0);
         ESPP_ASSERT(_client != nullptr);
+        if(data_len == 0) {
+            // client takes strlen of data for zero length
+            data = "";
+        }
         return ESP_OK == esp_mqtt_client_publish(_client, topic, data, data_len, 0, retain ? 1 : 0);
     }
 
@@ -83,10 +87,10 @@ private:
     const std::string _status_topic;
     const int _keep_alive_timeout = 15;
 
-    Mutex _mutex;
+    Mutex _mutex{"mqtt"};
     esp_mqtt_client_handle_t _client = nullptr;
     SubList _subscriptions;
-    bool _is_connected = true;
+    std::atomic<bool> _is_connected{true};
 
     static
     esp_err_t _EventHandler(esp_mqtt_event_handle_t event);
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <string>
+
+#include "espp/mqtt.h"
+#include "espp/protobuf.h"
+
+namespace espp {
+
+/**
+ * Subscription which gets whole payloads of protobuf messages.
+ *
+ * Fragmented messages are dropped. Empty payload is delivered, because
+ * proto3 message with all default fields is packed to nothing.
+ */
+class ProtoPayloadSubscription: public MqttSubscription {
+public:
+    void OnEvent(esp_mqtt_event_handle_t event) override
+    {
+        if(event->data_len != event->total_data_len) {
+            ERROR << "Fragmented protobuf message isn't supported. Length" << event->total_data_len;
+            _errors += 1;
+            return;
+        }
+        if(event->data_len == 0) {
+            OnEventData(Buffer(""));
+            return;
+        }
+        MqttSubscription::OnEvent(event);
+    }
+
+    /** Number of dropped messages */
+    unsigned int errors() const
+    {
+        return _errors;
+    }
+
+protected:
+    unsigned int _errors = 0;
+};
+
+/**
+ * Subscription which decodes messages into reusable PROTO wrapper.
+ *
+ * Message is unpacked into arena owned by subscription, so decoding
+ * doesn't use heap. Message is valid only during OnMessage call.
+ *
+ * @tparam Msg PROTO wrapper
+ * @tparam arenaSize memory budget of unpacked message
+ */
+template<class Msg, std::size_t arenaSize = 256>
+class ProtoSubscription: public ProtoPayloadSubscription {
+public:
+    void OnEventData(const Buffer& msg) override
+    {
+        if(!_message.Unpack(msg, _arena)) {
+            ERROR << "Can't unpack protobuf message with length" << msg.length();
+            _errors += 1;
+            return;
+        }
+        OnMessage(_message);
+    }
+
+    const ProtoArena& arena() const
+    {
+        return _arena;
+    }
+
+protected:
+    virtual void OnMessage(const Msg& msg) = 0;
+
+private:
+    Msg _message;
+    StaticProtoArena<arenaSize> _arena;
+};
+
+/**
+ * Publish PROTO wrappers to one topic.
+ *
+ * Message is packed into static buffer and passed to Mqtt without copy.
+ * Message with all default fields is published as empty payload
+ * (on retained topic broker treats it as removal of retained message).
+ *
+ * @tparam Msg PROTO wrapper
+ * @tparam bufferSize max packed size of message
+ */
+template<class Msg, std::size_t bufferSize = 256>
+class ProtoPublisher {
+public:
+    ProtoPublisher(Mqtt& mqtt, std::string topic, bool retain = false):
+        _mqtt(mqtt),
+        _topic(std::move(topic)),
+        _retain(retain)
+    {
+    }
+
+    ProtoPublisher(const ProtoPublisher&) = delete;
+
+    bool Publish(const Msg& msg)
+    {
+        if(!msg.PackTo(_buffer)) {
+            ERROR << "Protobuf message doesn't fit buffer. Size" << msg.PackedSize();
+            return false;
+        }
+        return _mqtt.Publish(_topic, _buffer, _retain);
+    }
+
+    const Data& topic() const
+    {
+        return _topic;
+    }
+
+private:
+    Mqtt& _mqtt;
+    const Data _topic;
+    const bool _retain;
+    StaticBuffer<bufferSize> _buffer;
+};
+
+/**
+ * Example
+ *
+ *      PROTO(LampCommand, lamp_command)
+ *      };
+ *
+ *      class CommandSubscription: public ProtoSubscription<LampCommandMsg> {
+ *      protected:
+ *          void OnMessage(const LampCommandMsg& msg) override;
+ *      };
+ *
+ *      ProtoPublisher<LampStateMsg> state_publisher(mqtt, "lamp/state", true);
+ *      state_publisher.Publish(state);
+ */
+
+}
@@ -0,0 +1,159 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <type_traits>
+
+#include "espp/mqtt.h"
+#include "espp/mqtt_protobuf.h"
+#include "espp/protobuf_delta.h"
+
+namespace espp {
+
+/**
+ * Publish PROTO wrapper as keyframes to topic and deltas to topic + "/delta".
+ *
+ * Receiver replaces state by keyframe and merges deltas into it (see ProtoDeltaSubscription).
+ * Deltas are never retained.
+ *
+ * @tparam Msg PROTO wrapper
+ * @tparam bufferSize max packed size of message
+ * @tparam maxFields max number of fields in message
+ */
+template<class Msg, std::size_t bufferSize = 256, std::size_t maxFields = 16>
+class ProtoDeltaPublisher {
+public:
+    ProtoDeltaPublisher(Mqtt& mqtt, const std::string& topic, unsigned int keyframe_interval = 10, bool retain = false):
+        _mqtt(mqtt),
+        _topic(topic),
+        _delta_topic(topic + "/delta"),
+        _retain(retain),
+        _hashes(),
+        _pending(),
+        _delta(_hashes.data(), _pending.data(), maxFields, keyframe_interval)
+    {
+    }
+
+    ProtoDeltaPublisher(const ProtoDeltaPublisher&) = delete;
+
+    bool Publish(const Msg& msg)
+    {
+        auto& delta = *reinterpret_cast<ProtobufCMessage*>(&_scratch);
+        const auto kind = _delta.Prepare(*reinterpret_cast<const ProtobufCMessage*>(&msg), delta);
+        if(kind == ProtoDelta::Kind::unchanged) {
+            VERBOSE << "Message wasn't changed. Skip";
+            return true;
+        }
+        const std::size_t size = protobuf_c_message_get_packed_size(&delta);
+        if(size > bufferSize) {
+            ERROR << "Protobuf message doesn't fit buffer. Size" << size;
+            return false;
+        }
+        _buffer.Resize(protobuf_c_message_pack(&delta, _buffer.writeData()));
+        const bool is_published = kind == ProtoDelta::Kind::keyframe
+            ? _mqtt.Publish(_topic, _buffer, _retain)
+            : _mqtt.Publish(_delta_topic, _buffer, false);
+        if(is_published) {
+            _delta.Commit();
+        }
+        return is_published;
+    }
+
+    void ForceKeyframe()
+    {
+        _delta.ForceKeyframe();
+    }
+
+    const ProtoDelta& delta() const
+    {
+        return _delta;
+    }
+
+private:
+    Mqtt& _mqtt;
+    const Data _topic;
+    const Data _delta_topic;
+    const bool _retain;
+    std::array<uint32_t, maxFields> _hashes;
+    std::array<uint32_t, maxFields> _pending;
+    ProtoDelta _delta;
+    typename std::aligned_storage<sizeof(Msg), alignof(Msg)>::type _scratch;
+    StaticBuffer<bufferSize> _buffer;
+};
+
+/**
+ * Subscription to keyframes and deltas of ProtoDeltaPublisher.
+ *
+ * Example
+ *
+ *      class StateSubscription: public ProtoDeltaSubscription<LampStateMsg> {
+ *      protected:
+ *          void OnMessage(const LampStateMsg& msg) override;
+ *      };
+ *
+ *      state_subscription.Subscribe(mqtt, "lamp/state");
+ */
+template<class Msg, std::size_t bufferSize = 512, std::size_t arenaSize = 256>
+class ProtoDeltaSubscription {
+public:
+    ProtoDeltaSubscription():
+        _keyframes(*this, true),
+        _deltas(*this, false)
+    {
+    }
+
+    ProtoDeltaSubscription(const ProtoDeltaSubscription&) = delete;
+
+    virtual ~ProtoDeltaSubscription() = default;
+
+    /** Subscribe to keyframes in topic and deltas in topic + "/delta" */
+    void Subscribe(Mqtt& mqtt, const std::string& topic)
+    {
+        mqtt.Subscribe(_keyframes, topic);
+        mqtt.Subscribe(_deltas, topic + "/delta");
+    }
+
+    /** Number of dropped keyframes and deltas */
+    unsigned int errors() const
+    {
+        return _keyframes.errors() + _deltas.errors();
+    }
+
+    const ProtoDeltaState<Msg, bufferSize, arenaSize>& state() const
+    {
+        return _state;
+    }
+
+protected:
+    virtual void OnMessage(const Msg& msg) = 0;
+
+private:
+    class Part: public ProtoPayloadSubscription {
+    public:
+        Part(ProtoDeltaSubscription& owner, bool is_keyframe):
+            _owner(owner),
+            _is_keyframe(is_keyframe)
+        {
+        }
+
+        void OnEventData(const Buffer& msg) override
+        {
+            auto& state = _owner._state;
+            if(!(_is_keyframe ? state.ApplyKeyframe(msg) : state.ApplyDelta(msg))) {
+                _errors += 1;
+                return;
+            }
+            _owner.OnMessage(state.message());
+        }
+
+    private:
+        ProtoDeltaSubscription& _owner;
+        const bool _is_keyframe;
+    };
+
+    ProtoDeltaState<Msg, bufferSize, arenaSize> _state;
+    Part _keyframes;
+    Part _deltas;
+};
+
+}
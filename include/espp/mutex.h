@@ -2,10 +2,19 @@
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#include <array>
 
 #include "espp/utils/macros.h"
 
+#ifdef ESPP_MUTEX_PROFILING
+#include "esp8266/eagle_soc.h"
+#endif
 
+#ifdef ESPP_LOCK_ORDER_CHECK
+#include "espp/lock_order.h"
+#endif
 
 namespace espp {
 
@@ -27,29 +36,167 @@ public:
     }
 };
 
+/**
+ * Contention statistic of one mutex.
+ *
+ * Collected only if ESPP_MUTEX_PROFILING is defined. All times are in CPU cycles.
+ * Profiles of all live mutexes are kept in registry and can be dumped by Dump.
+ */
+class MutexProfile {
+public:
+    /** Bucket i counts waits below 1024 * 4^i cycles, last one counts everything else */
+    static const std::size_t HISTOGRAM_SIZE = 8;
+    static const std::size_t NAME_LENGTH = 16;
+
+    explicit
+    MutexProfile(const char* name);
+
+    ~MutexProfile();
+
+    MutexProfile(const MutexProfile&) = delete;
+
+    MutexProfile& operator=(const MutexProfile&) = delete;
+
+    const char* name() const
+    {
+        return _name == nullptr ? "" : _name;
+    }
+
+    uint32_t acquired() const
+    {
+        return _acquired;
+    }
+
+    uint32_t contended() const
+    {
+        return _contended;
+    }
+
+    const std::array<uint32_t, HISTOGRAM_SIZE>& wait_histogram() const
+    {
+        return _wait_histogram;
+    }
+
+    uint32_t max_wait() const
+    {
+        return _max_wait;
+    }
+
+    uint32_t max_hold() const
+    {
+        return _max_hold;
+    }
+
+    /** Task which owned mutex during the longest wait */
+    const char* max_wait_owner() const
+    {
+        return _max_wait_owner;
+    }
+
+    /** Called by waiter before blocking. Return current owner */
+    TaskHandle_t owner() const
+    {
+        return _owner;
+    }
+
+    /** Called when mutex is taken */
+    void OnLocked(uint32_t start, uint32_t now, bool contended, TaskHandle_t prev_owner);
+
+    /** Called before mutex is given */
+    void OnUnlock(uint32_t now);
+
+    void Reset();
+
+    /** Log statistic of registered mutexes, at most 8 of them. Stack of caller holds a copy */
+    static
+    void Dump();
+
+    /** Reset statistic of all registered mutexes */
+    static
+    void ResetAll();
+
+private:
+    const char* const _name;
+    MutexProfile* _next = nullptr;
+    TaskHandle_t _owner = nullptr;
+    uint32_t _lock_time = 0;
+
+    uint32_t _acquired = 0;
+    uint32_t _contended = 0;
+    std::array<uint32_t, HISTOGRAM_SIZE> _wait_histogram = {};
+    uint32_t _max_wait = 0;
+    uint32_t _max_hold = 0;
+    char _max_wait_owner[NAME_LENGTH] = {};
+
+    static
+    MutexProfile*& _First()
+    {
+        static MutexProfile* first = nullptr;
+        return first;
+    }
+};
+
 template<TickType_t blockTime = pdMS_TO_TICKS(1000)>
 class Mutex {
 private:
     const SemaphoreHandle_t _handle;
+#ifdef ESPP_MUTEX_PROFILING
+    MutexProfile _profile;
+#endif
+#ifdef ESPP_LOCK_ORDER_CHECK
+    const uint8_t _lock_id;
+#endif
 
 public:
     using LockGuard = ::espp::LockGuard<Mutex<blockTime>>;
 
-    Mutex(): _handle(xSemaphoreCreateMutex())
+    /** Name is used only by profiling and lock order check */
+    explicit
+    Mutex(const char* name = nullptr):
+        _handle(xSemaphoreCreateMutex())
+#ifdef ESPP_MUTEX_PROFILING
+        , _profile(name)
+#endif
+#ifdef ESPP_LOCK_ORDER_CHECK
+        , _lock_id(LockOrder::Register(name))
+#endif
     {
+        (void)name;
     }
 
     void Lock()
     {
         VERBOSE << "LOCK MUTEX" << _handle;
+#ifdef ESPP_LOCK_ORDER_CHECK
+        LockOrder::OnAcquire(_lock_id);
+#endif
+#ifdef ESPP_MUTEX_PROFILING
+        const uint32_t start = soc_get_ccount();
+        TaskHandle_t owner = nullptr;
+        const bool contended = xSemaphoreTake(_handle, 0) != pdPASS;
+        if(contended) {
+            owner = _profile.owner();
+            ESPP_CHECK(xSemaphoreTake(_handle, blockTime) == pdPASS);
+        }
+        _profile.OnLocked(start, soc_get_ccount(), contended, owner);
+#else
         ESPP_CHECK(xSemaphoreTake(_handle, blockTime) == pdPASS);
+#endif
         VERBOSE << "LOCKED";
     }
 
     inline
     bool TryLock(TickType_t ticKNumber)
     {
-        return pdTRUE == xSemaphoreTake(_handle, ticKNumber);
+#ifdef ESPP_LOCK_ORDER_CHECK
+        if(!_TryLock(ticKNumber)) {
+            return false;
+        }
+        LockOrder::OnAcquire(_lock_id);
+        return true;
+#else
+        return _TryLock(ticKNumber);
+#endif
     }
 
     inline
@@ -61,9 +208,35 @@ public:
     inline
     void Unlock()
     {
+#ifdef ESPP_LOCK_ORDER_CHECK
+        LockOrder::OnRelease(_lock_id);
+#endif
+#ifdef ESPP_MUTEX_PROFILING
+        _profile.OnUnlock(soc_get_ccount());
+#endif
         xSemaphoreGive(_handle);
         VERBOSE << "UNLOCK MUTEX" << _handle;
     }
+
+private:
+    bool _TryLock(TickType_t ticKNumber)
+    {
+#ifdef ESPP_MUTEX_PROFILING
+        const uint32_t start = soc_get_ccount();
+        if(xSemaphoreTake(_handle, 0) == pdPASS) {
+            _profile.OnLocked(start, start, false, nullptr);
+            return true;
+        }
+        const TaskHandle_t owner = _profile.owner();
+        if(ticKNumber == 0 || xSemaphoreTake(_handle, ticKNumber) != pdPASS) {
+            return false;
+        }
+        _profile.OnLocked(start, soc_get_ccount(), true, owner);
+        return true;
+#else
+        return pdTRUE == xSemaphoreTake(_handle, ticKNumber);
+#endif
+    }
 };
 
-}
\ No newline at end of file
+}
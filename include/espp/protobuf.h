@@ -2,12 +2,165 @@
 
 #include <string>
 #include <vector>
+#include <cstring>
+#include <type_traits>
+
+#include <protobuf-c/protobuf-c.h>
+
+#include "espp/buffer.h"
+
+namespace espp {
+
+/**
+ * protobuf-c stream sink which writes into preallocated memory.
+ *
+ * Bytes which don't fit are dropped and sink is marked as overflowed
+ */
+struct ProtoSink: public ProtobufCBuffer {
+    ProtoSink(uint8_t* data, std::size_t capacity):
+        ProtobufCBuffer{_Append},
+        _data(data),
+        _capacity(capacity)
+    {
+    }
+
+    std::size_t length() const
+    {
+        return _length;
+    }
+
+    bool isOverflowed() const
+    {
+        return _is_overflowed;
+    }
+
+private:
+    uint8_t* const _data;
+    const std::size_t _capacity;
+    std::size_t _length = 0;
+    bool _is_overflowed = false;
+
+    static
+    void _Append(ProtobufCBuffer* buffer, std::size_t length, const uint8_t* data)
+    {
+        auto* sink = static_cast<ProtoSink*>(buffer);
+        if(sink->_is_overflowed || length > sink->_capacity - sink->_length) {
+            sink->_is_overflowed = true;
+            return;
+        }
+        std::memcpy(sink->_data + sink->_length, data, length);
+        sink->_length += length;
+    }
+};
+
+/**
+ * Bump allocator for protobuf-c unpack.
+ *
+ * Free is no-op and all memory is released at once by Reset.
+ * Allocation above capacity fails, so unpack returns error instead of aborting.
+ */
+class ProtoArena {
+public:
+    ProtoArena(uint8_t* data, std::size_t capacity):
+        _allocator{_Alloc, _Free, this},
+        _data(data),
+        _capacity(capacity)
+    {
+    }
+
+    ProtoArena(const ProtoArena&) = delete;
+
+    ProtoArena& operator=(const ProtoArena&) = delete;
+
+    ProtobufCAllocator* allocator()
+    {
+        return &_allocator;
+    }
+
+    void Reset()
+    {
+        _used = 0;
+    }
+
+    std::size_t capacity() const
+    {
+        return _capacity;
+    }
+
+    std::size_t used() const
+    {
+        return _used;
+    }
+
+    /** Max used memory since creation. Can be used to tune capacity */
+    std::size_t peak() const
+    {
+        return _peak;
+    }
+
+    /** Number of allocations rejected due to capacity */
+    unsigned int failures() const
+    {
+        return _failures;
+    }
+
+private:
+    static const std::size_t _alignment = 8;
+
+    ProtobufCAllocator _allocator;
+    uint8_t* const _data;
+    const std::size_t _capacity;
+    std::size_t _used = 0;
+    std::size_t _peak = 0;
+    unsigned int _failures = 0;
+
+    static
+    void* _Alloc(void* context, std::size_t size)
+    {
+        auto* arena = reinterpret_cast<ProtoArena*>(context);
+        const std::size_t aligned_size = (size + _alignment - 1) & ~(_alignment - 1);
+        if(aligned_size > arena->_capacity - arena->_used) {
+            arena->_failures += 1;
+            return nullptr;
+        }
+        void* result = arena->_data + arena->_used;
+        arena->_used += aligned_size;
+        if(arena->_used > arena->_peak) {
+            arena->_peak = arena->_used;
+        }
+        return result;
+    }
+
+    static
+    void _Free(void*, void*)
+    {
+    }
+};
+
+/**
+ * Arena which owns its memory
+ *
+ * @tparam size memory budget for one unpacked message
+ */
+template<std::size_t size>
+class StaticProtoArena: public ProtoArena {
+public:
+    StaticProtoArena():
+        ProtoArena(reinterpret_cast<uint8_t*>(&_storage), size)
+    {
+    }
+
+private:
+    typename std::aligned_storage<size, 8>::type _storage;
+};
+
+}
 
 #define PROTO_NAME(x) x ## Msg
 
 #define PROTO_CONSTRUCT(x, p) PROTO_NAME(x) (): x{} { p##__init(this); }
 #define PROTO_CONSTRUCT_NESTED(x, p, xx) xx (): x{} { p##__init(this); }
-#define PROTO_DECONSTRUCT(x, p) ~PROTO_NAME(x) () { if (_is_unpacked) { p##__free_unpacked(this, nullptr);} }
+#define PROTO_DECONSTRUCT(x, p) ~PROTO_NAME(x) () { if (_unpacked != nullptr) { p##__free_unpacked(_unpacked, nullptr);} }
 #define PROTO_NO_COPY(x) \
     PROTO_NAME(x) (const PROTO_NAME(x)&) = delete; \
     PROTO_NAME(x)& operator=(const PROTO_NAME(x)&) = delete;
@@ -17,14 +170,40 @@
         std::size_t size = p##__get_packed_size(this); std::vector<uint8_t> buffer(size); \
         p##__pack(this, buffer.data()); return buffer; \
     } \
-    void Unpack(const std::vector<uint8_t>& buffer) { \
-        assert(!_is_unpacked); \
-        *static_cast<x*>(this) = *p##__unpack(nullptr, buffer.size(), buffer.data()); \
-        _is_unpacked = true; \
+    std::size_t PackedSize() const { return p##__get_packed_size(this); } \
+    /** Return packed length or 0 if buffer is too small */ \
+    std::size_t PackTo(uint8_t* buffer, std::size_t length) const { \
+        if(p##__get_packed_size(this) > length) { return 0; } \
+        return p##__pack(this, buffer); \
+    } \
+    template<std::size_t size> bool PackTo(espp::StaticBuffer<size>& buffer) const { \
+        if(p##__get_packed_size(this) > size) { buffer.Clear(); return false; } \
+        buffer.Resize(p##__pack(this, buffer.writeData())); return true; \
+    } \
+    std::size_t PackTo(ProtobufCBuffer& sink) const { return p##__pack_to_buffer(this, &sink); } \
+    /** Release previous unpacked data. Fields are reset to default */ \
+    void ReleaseUnpacked() { \
+        if(_unpacked != nullptr) { p##__free_unpacked(_unpacked, nullptr); _unpacked = nullptr; } \
+        p##__init(this); \
+    } \
+    bool Unpack(const uint8_t* data, std::size_t length) { \
+        ReleaseUnpacked(); \
+        x* msg = p##__unpack(nullptr, length, data); \
+        if(msg == nullptr) { return false; } \
+        *static_cast<x*>(this) = *msg; _unpacked = msg; return true; \
+    } \
+    bool Unpack(const std::vector<uint8_t>& buffer) { return Unpack(buffer.data(), buffer.size()); } \
+    bool Unpack(const espp::Buffer& buffer) { return Unpack(buffer.data(), buffer.length()); } \
+    /** Unpack into arena. Arena is reset, so previous message from it becomes invalid */ \
+    bool Unpack(const espp::Buffer& buffer, espp::ProtoArena& arena) { \
+        ReleaseUnpacked(); arena.Reset(); \
+        x* msg = p##__unpack(arena.allocator(), buffer.length(), buffer.data()); \
+        if(msg == nullptr) { return false; } \
+        *static_cast<x*>(this) = *msg; return true; \
     }
 
 #define PROTO(x, p) struct PROTO_NAME(x): public x { \
-    bool _is_unpacked = false; \
+    x* _unpacked = nullptr; \
     PROTO_CONSTRUCT(x, p) \
     PROTO_DECONSTRUCT(x, p) \
     PROTO_NO_COPY(x) \
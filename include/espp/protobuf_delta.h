@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include <protobuf-c/protobuf-c.h>
+
+#include "espp/log.h"
+#include "espp/protobuf.h"
+
+namespace espp {
+
+/**
+ * Field-level delta encoder for repeated publishes of same message.
+ *
+ * Keep hash of every field of last sent message and clear unchanged fields
+ * in shallow copy of message, so only changed fields are packed.
+ * Full message (keyframe) is sent periodically and when delta can't express
+ * change by protobuf merge: field was reset, repeated field was changed
+ * (merge appends items) or nested message was changed (merge can't clear its fields).
+ * Required and oneof fields are always sent.
+ *
+ * Hashes are updated by Commit after prepared message was sent,
+ * so failed publish is repeated by next Prepare.
+ */
+class ProtoDelta {
+public:
+    enum class Kind {
+        unchanged,
+        keyframe,
+        delta,
+    };
+
+    /**
+     * @param hashes memory for max_fields hashes of last sent message
+     * @param pending memory for max_fields hashes of prepared message
+     */
+    ProtoDelta(uint32_t* hashes, uint32_t* pending, std::size_t max_fields, unsigned int keyframe_interval):
+        _hashes(hashes),
+        _pending(pending),
+        _max_fields(max_fields),
+        _keyframe_interval(keyframe_interval)
+    {
+    }
+
+    ProtoDelta(const ProtoDelta&) = delete;
+
+    /**
+     * Compare message with last sent one and prepare message to pack.
+     *
+     * @param msg current message
+     * @param delta memory for shallow copy of message (descriptor->sizeof_message)
+     */
+    Kind Prepare(const ProtobufCMessage& msg, ProtobufCMessage& delta);
+
+    /** Prepared keyframe or delta was sent */
+    void Commit();
+
+    /** Next prepared message will be keyframe. Should be called after reconnect */
+    void ForceKeyframe()
+    {
+        _has_keyframe = false;
+    }
+
+    unsigned int keyframes() const
+    {
+        return _keyframes;
+    }
+
+    unsigned int deltas() const
+    {
+        return _deltas;
+    }
+
+    unsigned int skipped() const
+    {
+        return _skipped;
+    }
+
+private:
+    uint32_t* const _hashes;
+    uint32_t* const _pending;
+    const std::size_t _max_fields;
+    const unsigned int _keyframe_interval;
+    std::size_t _pending_fields = 0;
+    Kind _pending_kind = Kind::unchanged;
+    unsigned int _since_keyframe = 0;
+    unsigned int _keyframes = 0;
+    unsigned int _deltas = 0;
+    unsigned int _skipped = 0;
+    bool _has_keyframe = false;
+};
+
+/**
+ * Message state restored from keyframes and deltas.
+ *
+ * Protobuf merge of messages is concatenation of packed messages, so delta is
+ * appended to packed state and result is unpacked. Merged message is packed back,
+ * so packed state doesn't grow.
+ *
+ * @tparam Msg PROTO wrapper
+ * @tparam bufferSize max packed size of message and delta together
+ * @tparam arenaSize memory budget of unpacked message
+ */
+template<class Msg, std::size_t bufferSize = 512, std::size_t arenaSize = 256>
+class ProtoDeltaState {
+public:
+    ProtoDeltaState() = default;
+
+    ProtoDeltaState(const ProtoDeltaState&) = delete;
+
+    bool ApplyKeyframe(const Buffer& packed)
+    {
+        _has_keyframe = false;
+        if(packed.length() > bufferSize) {
+            ERROR << "Keyframe doesn't fit buffer. Length" << packed.length();
+            return false;
+        }
+        _packed.Resize(packed.CopyTo(_packed.writeData(), bufferSize));
+        return _Unpack();
+    }
+
+    /** Delta is ignored until keyframe is received */
+    bool ApplyDelta(const Buffer& packed)
+    {
+        if(!_has_keyframe) {
+            DEBUG << "Skip delta without keyframe";
+            return false;
+        }
+        if(packed.length() > bufferSize - _packed.length()) {
+            ERROR << "Delta doesn't fit buffer. Wait keyframe";
+            _has_keyframe = false;
+            return false;
+        }
+        const std::size_t length = _packed.length();
+        _packed.Resize(length + packed.CopyTo(_packed.writeData() + length, bufferSize - length));
+        return _Unpack();
+    }
+
+    bool hasKeyframe() const
+    {
+        return _has_keyframe;
+    }
+
+    /** Valid until next Apply */
+    const Msg& message() const
+    {
+        return _message;
+    }
+
+private:
+    Msg _message;
+    StaticProtoArena<arenaSize> _arena;
+    StaticBuffer<bufferSize> _packed;
+    bool _has_keyframe = false;
+
+    bool _Unpack()
+    {
+        // unpacked message doesn't point to packed data, so it can be packed back
+        if(!_message.Unpack(_packed, _arena) || !_message.PackTo(_packed)) {
+            ERROR << "Can't merge protobuf message. Wait keyframe";
+            _packed.Clear();
+            _has_keyframe = false;
+            return false;
+        }
+        _has_keyframe = true;
+        return true;
+    }
+};
+
+}
@@ -0,0 +1,755 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include <protobuf-c/protobuf-c.h>
+
+#include "espp/buffer.h"
+#include "espp/utils/test.h"
+
+#ifdef ENABLE_TEST
+#include <vector>
+#include "espp/utils/low_level.h"
+#endif
+
+namespace espp {
+namespace proto {
+
+/**
+ * Compile-time protobuf encoders.
+ *
+ * Field table is declared as template arguments, so packing doesn't
+ * interpret protobuf-c descriptors. Output is same as protobuf-c if fields
+ * are listed in same order as in .proto file. Encoder::Matches compares
+ * table with generated descriptor.
+ * Default values of optional strings, oneof and unknown fields aren't supported.
+ */
+
+inline
+std::size_t VarintSize32(uint32_t v)
+{
+    return v < (1u << 7u) ? 1 : v < (1u << 14u) ? 2 : v < (1u << 21u) ? 3 : v < (1u << 28u) ? 4 : 5;
+}
+
+inline
+std::size_t VarintSize64(uint64_t v)
+{
+    if((v >> 32u) == 0) {
+        return VarintSize32(static_cast<uint32_t>(v));
+    }
+    std::size_t result = 5;
+    for(v >>= 35u; v != 0; v >>= 7u) {
+        result += 1;
+    }
+    return result;
+}
+
+inline
+uint8_t* PutVarint32(uint8_t* out, uint32_t v)
+{
+    while(v >= 0x80u) {
+        *out++ = static_cast<uint8_t>(v | 0x80u);
+        v >>= 7u;
+    }
+    *out++ = static_cast<uint8_t>(v);
+    return out;
+}
+
+inline
+uint8_t* PutVarint64(uint8_t* out, uint64_t v)
+{
+    while(v >= 0x80u) {
+        *out++ = static_cast<uint8_t>(v | 0x80u);
+        v >>= 7u;
+    }
+    *out++ = static_cast<uint8_t>(v);
+    return out;
+}
+
+template<class T>
+inline
+uint8_t* PutFixed(uint8_t* out, T v)
+{
+    std::memcpy(out, &v, sizeof(T));
+    return out + sizeof(T);
+}
+
+constexpr
+std::size_t TagSize(uint32_t tag)
+{
+    return tag < (1u << 7u) ? 1 : tag < (1u << 14u) ? 2 : tag < (1u << 21u) ? 3 : tag < (1u << 28u) ? 4 : 5;
+}
+
+/**
+ * Offset of member like offsetof, which doesn't accept pointer to member.
+ *
+ * Address is taken in real zeroed message, protobuf-c messages are plain structs.
+ * Used only by descriptor check, so message on stack is fine
+ */
+template<class Cls, class T>
+inline
+std::size_t MemberOffset(T Cls::* member)
+{
+    const Cls probe = Cls();
+    return reinterpret_cast<const uint8_t*>(&(probe.*member)) - reinterpret_cast<const uint8_t*>(&probe);
+}
+
+template<uint32_t id, uint8_t wire>
+struct Tag {
+    static const uint32_t value = (id << 3u) | wire;
+    static constexpr std::size_t size = TagSize(value);
+
+    static
+    uint8_t* Put(uint8_t* out)
+    {
+        return PutVarint32(out, value);
+    }
+};
+
+/** Items of packed field don't have tag */
+struct NoTag {
+    static constexpr std::size_t size = 0;
+
+    static
+    uint8_t* Put(uint8_t* out)
+    {
+        return out;
+    }
+};
+
+enum Wire: uint8_t {
+    VARINT = 0,
+    FIXED64 = 1,
+    LENGTH_DELIMITED = 2,
+    FIXED32 = 5,
+};
+
+// Value codecs. Size and Put don't include tag
+
+struct UInt32 {
+    static const uint8_t wire = VARINT;
+    static std::size_t Size(uint32_t v) { return VarintSize32(v); }
+    static uint8_t* Put(uint8_t* out, uint32_t v) { return PutVarint32(out, v); }
+    static bool IsZero(uint32_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_UINT32; }
+};
+
+struct Int32 {
+    static const uint8_t wire = VARINT;
+    static std::size_t Size(int32_t v) { return v < 0 ? 10 : VarintSize32(static_cast<uint32_t>(v)); }
+    static uint8_t* Put(uint8_t* out, int32_t v) { return PutVarint64(out, static_cast<uint64_t>(static_cast<int64_t>(v))); }
+    static bool IsZero(int32_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_INT32 || type == PROTOBUF_C_TYPE_ENUM; }
+};
+
+using Enum = Int32;
+
+struct SInt32 {
+    static const uint8_t wire = VARINT;
+    static uint32_t ZigZag(int32_t v) { return (static_cast<uint32_t>(v) << 1u) ^ static_cast<uint32_t>(v >> 31); }
+    static std::size_t Size(int32_t v) { return VarintSize32(ZigZag(v)); }
+    static uint8_t* Put(uint8_t* out, int32_t v) { return PutVarint32(out, ZigZag(v)); }
+    static bool IsZero(int32_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_SINT32; }
+};
+
+struct UInt64 {
+    static const uint8_t wire = VARINT;
+    static std::size_t Size(uint64_t v) { return VarintSize64(v); }
+    static uint8_t* Put(uint8_t* out, uint64_t v) { return PutVarint64(out, v); }
+    static bool IsZero(uint64_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_UINT64; }
+};
+
+struct Int64 {
+    static const uint8_t wire = VARINT;
+    static std::size_t Size(int64_t v) { return VarintSize64(static_cast<uint64_t>(v)); }
+    static uint8_t* Put(uint8_t* out, int64_t v) { return PutVarint64(out, static_cast<uint64_t>(v)); }
+    static bool IsZero(int64_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_INT64; }
+};
+
+struct SInt64 {
+    static const uint8_t wire = VARINT;
+    static uint64_t ZigZag(int64_t v) { return (static_cast<uint64_t>(v) << 1u) ^ static_cast<uint64_t>(v >> 63); }
+    static std::size_t Size(int64_t v) { return VarintSize64(ZigZag(v)); }
+    static uint8_t* Put(uint8_t* out, int64_t v) { return PutVarint64(out, ZigZag(v)); }
+    static bool IsZero(int64_t v) { return v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_SINT64; }
+};
+
+struct Bool {
+    static const uint8_t wire = VARINT;
+    static std::size_t Size(protobuf_c_boolean) { return 1; }
+    static uint8_t* Put(uint8_t* out, protobuf_c_boolean v) { *out = v ? 1 : 0; return out + 1; }
+    static bool IsZero(protobuf_c_boolean v) { return !v; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_BOOL; }
+};
+
+template<class T, uint8_t wireType, ProtobufCType protoType>
+struct FixedCodec {
+    static const uint8_t wire = wireType;
+    static std::size_t Size(T) { return sizeof(T); }
+    static uint8_t* Put(uint8_t* out, T v) { return PutFixed(out, v); }
+    static bool Matches(ProtobufCType type) { return type == protoType; }
+
+    static bool IsZero(T v)
+    {
+        // same as protobuf-c: -0.0 isn't zero
+        static const T zero = 0;
+        return std::memcmp(&v, &zero, sizeof(T)) == 0;
+    }
+};
+
+using Fixed32 = FixedCodec<uint32_t, FIXED32, PROTOBUF_C_TYPE_FIXED32>;
+using SFixed32 = FixedCodec<int32_t, FIXED32, PROTOBUF_C_TYPE_SFIXED32>;
+using Float = FixedCodec<float, FIXED32, PROTOBUF_C_TYPE_FLOAT>;
+using Fixed64 = FixedCodec<uint64_t, FIXED64, PROTOBUF_C_TYPE_FIXED64>;
+using SFixed64 = FixedCodec<int64_t, FIXED64, PROTOBUF_C_TYPE_SFIXED64>;
+using Double = FixedCodec<double, FIXED64, PROTOBUF_C_TYPE_DOUBLE>;
+
+struct String {
+    static const uint8_t wire = LENGTH_DELIMITED;
+
+    static std::size_t Size(const char* v)
+    {
+        const std::size_t length = v == nullptr ? 0 : std::strlen(v);
+        return VarintSize32(length) + length;
+    }
+
+    static uint8_t* Put(uint8_t* out, const char* v)
+    {
+        const std::size_t length = v == nullptr ? 0 : std::strlen(v);
+        out = PutVarint32(out, length);
+        if(length != 0) {
+            std::memcpy(out, v, length);
+        }
+        return out + length;
+    }
+
+    static bool IsZero(const char* v) { return v == nullptr || *v == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_STRING; }
+};
+
+struct Bytes {
+    static const uint8_t wire = LENGTH_DELIMITED;
+    static std::size_t Size(const ProtobufCBinaryData& v) { return VarintSize32(v.len) + v.len; }
+
+    static uint8_t* Put(uint8_t* out, const ProtobufCBinaryData& v)
+    {
+        out = PutVarint32(out, v.len);
+        if(v.len != 0) {
+            std::memcpy(out, v.data, v.len);
+        }
+        return out + v.len;
+    }
+
+    static bool IsZero(const ProtobufCBinaryData& v) { return v.len == 0; }
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_BYTES; }
+};
+
+/** Nested message encoded with Encoder */
+template<class Encoder>
+struct Message {
+    static const uint8_t wire = LENGTH_DELIMITED;
+
+    template<class M>
+    static std::size_t Size(const M* v)
+    {
+        const std::size_t length = v == nullptr ? 0 : Encoder::Size(*v);
+        return VarintSize32(length) + length;
+    }
+
+    template<class M>
+    static uint8_t* Put(uint8_t* out, const M* v)
+    {
+        if(v == nullptr) {
+            return PutVarint32(out, 0);
+        }
+        out = PutVarint32(out, Encoder::Size(*v));
+        return Encoder::Put(*v, out);
+    }
+
+    template<class M>
+    static bool IsZero(const M* v) { return v == nullptr; }
+
+    static bool Matches(ProtobufCType type) { return type == PROTOBUF_C_TYPE_MESSAGE; }
+};
+
+/**
+ * Append tag and value to protobuf-c sink.
+ *
+ * Scalars are put into small scratch. Strings and bytes are passed to sink without copy.
+ * Return number of appended bytes.
+ */
+template<class Codec>
+struct Appender {
+    template<class TagType, class T>
+    static std::size_t Append(ProtobufCBuffer* sink, const T& v)
+    {
+        uint8_t scratch[TagType::size + 10];
+        const std::size_t length = Codec::Put(TagType::Put(scratch), v) - scratch;
+        sink->append(sink, length, scratch);
+        return length;
+    }
+};
+
+inline
+std::size_t AppendLengthDelimited(ProtobufCBuffer* sink, uint8_t* scratch, uint8_t* out,
+                                  const uint8_t* data, std::size_t length)
+{
+    out = PutVarint32(out, length);
+    sink->append(sink, out - scratch, scratch);
+    if(length != 0) {
+        sink->append(sink, length, data);
+    }
+    return out - scratch + length;
+}
+
+template<>
+struct Appender<String> {
+    template<class TagType>
+    static std::size_t Append(ProtobufCBuffer* sink, const char* v)
+    {
+        uint8_t scratch[TagType::size + 5];
+        const std::size_t length = v == nullptr ? 0 : std::strlen(v);
+        return AppendLengthDelimited(sink, scratch, TagType::Put(scratch), reinterpret_cast<const uint8_t*>(v), length);
+    }
+};
+
+template<>
+struct Appender<Bytes> {
+    template<class TagType>
+    static std::size_t Append(ProtobufCBuffer* sink, const ProtobufCBinaryData& v)
+    {
+        uint8_t scratch[TagType::size + 5];
+        return AppendLengthDelimited(sink, scratch, TagType::Put(scratch), v.data, v.len);
+    }
+};
+
+template<class Encoder>
+struct Appender<Message<Encoder>> {
+    template<class TagType, class M>
+    static std::size_t Append(ProtobufCBuffer* sink, const M* v)
+    {
+        uint8_t scratch[TagType::size + 5];
+        const std::size_t length = v == nullptr ? 0 : Encoder::Size(*v);
+        const std::size_t header = PutVarint32(TagType::Put(scratch), length) - scratch;
+        sink->append(sink, header, scratch);
+        if(v != nullptr) {
+            Encoder::Append(*v, sink);
+        }
+        return header + length;
+    }
+};
+
+/** Common part of field and descriptor comparison */
+template<uint32_t id, class Codec, class Cls, class T>
+inline
+bool MatchesField(const ProtobufCFieldDescriptor& field, ProtobufCLabel label, T Cls::* member)
+{
+    return field.id == id && field.label == label && Codec::Matches(field.type)
+        && (field.flags & PROTOBUF_C_FIELD_FLAG_ONEOF) == 0 && field.offset == MemberOffset(member);
+}
+
+// Fields
+
+/** proto2 required field. Always packed */
+template<uint32_t id, class Codec, class Cls, class T, T Cls::* member>
+struct Required {
+    using TagType = Tag<id, Codec::wire>;
+
+    static std::size_t Size(const Cls& msg)
+    {
+        return TagType::size + Codec::Size(msg.*member);
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        return Codec::Put(TagType::Put(out), msg.*member);
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        return Appender<Codec>::template Append<TagType>(sink, msg.*member);
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_REQUIRED, member);
+    }
+};
+
+/** proto2 optional scalar field with has_ flag */
+template<uint32_t id, class Codec, class Cls, class T, T Cls::* member, protobuf_c_boolean Cls::* has>
+struct Optional {
+    using TagType = Tag<id, Codec::wire>;
+
+    static std::size_t Size(const Cls& msg)
+    {
+        return msg.*has ? TagType::size + Codec::Size(msg.*member) : 0;
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        return msg.*has ? Codec::Put(TagType::Put(out), msg.*member) : out;
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        return msg.*has ? Appender<Codec>::template Append<TagType>(sink, msg.*member) : 0;
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_OPTIONAL, member)
+            && field.quantifier_offset == MemberOffset(has);
+    }
+};
+
+/** proto2 optional string or message. Packed if pointer isn't null */
+template<uint32_t id, class Codec, class Cls, class T, T Cls::* member>
+struct OptionalPtr {
+    using TagType = Tag<id, Codec::wire>;
+
+    static std::size_t Size(const Cls& msg)
+    {
+        return msg.*member != nullptr ? TagType::size + Codec::Size(msg.*member) : 0;
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        return msg.*member != nullptr ? Codec::Put(TagType::Put(out), msg.*member) : out;
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        return msg.*member != nullptr ? Appender<Codec>::template Append<TagType>(sink, msg.*member) : 0;
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_OPTIONAL, member);
+    }
+};
+
+/** proto3 field without presence. Packed if value isn't zero */
+template<uint32_t id, class Codec, class Cls, class T, T Cls::* member>
+struct Implicit {
+    using TagType = Tag<id, Codec::wire>;
+
+    static std::size_t Size(const Cls& msg)
+    {
+        return Codec::IsZero(msg.*member) ? 0 : TagType::size + Codec::Size(msg.*member);
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        return Codec::IsZero(msg.*member) ? out : Codec::Put(TagType::Put(out), msg.*member);
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        return Codec::IsZero(msg.*member) ? 0 : Appender<Codec>::template Append<TagType>(sink, msg.*member);
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_NONE, member);
+    }
+};
+
+/** Repeated field which isn't packed. Each item has own tag */
+template<uint32_t id, class Codec, class Cls, class T, T* Cls::* member, std::size_t Cls::* count>
+struct Repeated {
+    using TagType = Tag<id, Codec::wire>;
+
+    static std::size_t Size(const Cls& msg)
+    {
+        std::size_t result = TagType::size * (msg.*count);
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            result += Codec::Size(*item);
+        }
+        return result;
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            out = Codec::Put(TagType::Put(out), *item);
+        }
+        return out;
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        std::size_t result = 0;
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            result += Appender<Codec>::template Append<TagType>(sink, *item);
+        }
+        return result;
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_REPEATED, member)
+            && (field.flags & PROTOBUF_C_FIELD_FLAG_PACKED) == 0 && field.quantifier_offset == MemberOffset(count);
+    }
+};
+
+/** Packed repeated numeric field */
+template<uint32_t id, class Codec, class Cls, class T, T* Cls::* member, std::size_t Cls::* count>
+struct Packed {
+    using TagType = Tag<id, LENGTH_DELIMITED>;
+
+    static std::size_t PayloadSize(const Cls& msg)
+    {
+        std::size_t result = 0;
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            result += Codec::Size(*item);
+        }
+        return result;
+    }
+
+    static std::size_t Size(const Cls& msg)
+    {
+        if(msg.*count == 0) {
+            return 0;
+        }
+        const std::size_t length = PayloadSize(msg);
+        return TagType::size + VarintSize32(length) + length;
+    }
+
+    static uint8_t* Put(const Cls& msg, uint8_t* out)
+    {
+        if(msg.*count == 0) {
+            return out;
+        }
+        out = PutVarint32(TagType::Put(out), PayloadSize(msg));
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            out = Codec::Put(out, *item);
+        }
+        return out;
+    }
+
+    static std::size_t Append(const Cls& msg, ProtobufCBuffer* sink)
+    {
+        if(msg.*count == 0) {
+            return 0;
+        }
+        uint8_t scratch[TagType::size + 5];
+        std::size_t result = PutVarint32(TagType::Put(scratch), PayloadSize(msg)) - scratch;
+        sink->append(sink, result, scratch);
+        for(const T* item = msg.*member, *end = item + msg.*count; item != end; ++item) {
+            result += Appender<Codec>::template Append<NoTag>(sink, *item);
+        }
+        return result;
+    }
+
+    static bool Matches(const ProtobufCFieldDescriptor& field)
+    {
+        return MatchesField<id, Codec>(field, PROTOBUF_C_LABEL_REPEATED, member)
+            && (field.flags & PROTOBUF_C_FIELD_FLAG_PACKED) != 0 && field.quantifier_offset == MemberOffset(count);
+    }
+};
+
+template<class... Fields>
+struct FieldList;
+
+template<>
+struct FieldList<> {
+    template<class T>
+    static std::size_t Size(const T&)
+    {
+        return 0;
+    }
+
+    template<class T>
+    static uint8_t* Put(const T&, uint8_t* out)
+    {
+        return out;
+    }
+
+    template<class T>
+    static std::size_t Append(const T&, ProtobufCBuffer*)
+    {
+        return 0;
+    }
+
+    static bool _Matches(const ProtobufCMessageDescriptor& descriptor, unsigned int idx, unsigned int* mismatch)
+    {
+        if(idx == descriptor.n_fields) {
+            return true;
+        }
+        if(mismatch != nullptr) {
+            *mismatch = idx;
+        }
+        return false;
+    }
+};
+
+template<class Field, class... Rest>
+struct FieldList<Field, Rest...> {
+    template<class T>
+    static std::size_t Size(const T& msg)
+    {
+        return Field::Size(msg) + FieldList<Rest...>::Size(msg);
+    }
+
+    template<class T>
+    static uint8_t* Put(const T& msg, uint8_t* out)
+    {
+        return FieldList<Rest...>::Put(msg, Field::Put(msg, out));
+    }
+
+    template<class T>
+    static std::size_t Append(const T& msg, ProtobufCBuffer* sink)
+    {
+        const std::size_t length = Field::Append(msg, sink);
+        return length + FieldList<Rest...>::Append(msg, sink);
+    }
+
+    static bool _Matches(const ProtobufCMessageDescriptor& descriptor, unsigned int idx, unsigned int* mismatch)
+    {
+        if(idx >= descriptor.n_fields || !Field::Matches(descriptor.fields[idx])) {
+            if(mismatch != nullptr) {
+                *mismatch = idx;
+            }
+            return false;
+        }
+        return FieldList<Rest...>::_Matches(descriptor, idx + 1, mismatch);
+    }
+};
+
+/**
+ * Encoder of message with fields
+ */
+template<class... Fields>
+struct Encoder: public FieldList<Fields...> {
+    using List = FieldList<Fields...>;
+
+    /** Return packed length or 0 if buffer is too small */
+    template<class T>
+    static std::size_t PackTo(const T& msg, uint8_t* buffer, std::size_t length)
+    {
+        if(List::Size(msg) > length) {
+            return 0;
+        }
+        return List::Put(msg, buffer) - buffer;
+    }
+
+    /** Pack into protobuf-c sink like protobuf_c_message_pack_to_buffer. Return packed length */
+    template<class T>
+    static std::size_t PackTo(const T& msg, ProtobufCBuffer* sink)
+    {
+        return List::Append(msg, sink);
+    }
+
+    /**
+     * Compare field table with generated descriptor: order, number, label, type and offsets.
+     *
+     * @param mismatch index of first field which doesn't match
+     */
+    static bool Matches(const ProtobufCMessageDescriptor& descriptor, unsigned int* mismatch = nullptr)
+    {
+        return List::_Matches(descriptor, 0, mismatch);
+    }
+};
+
+#ifdef ENABLE_TEST
+namespace testing {
+    struct EncoderTestResult {
+        bool matches_descriptor = false;
+        bool is_same = false;           ///< PackTo into buffer and sink give same bytes as protobuf-c
+        uint32_t encoder_cycles = 0;
+        uint32_t protobuf_c_cycles = 0;
+    };
+
+    /** Compare Encoder with protobuf_c_message_pack for message of application */
+    template<class Enc, class T>
+    EncoderTestResult testEncoderResult(const T& msg)
+    {
+        struct VectorSink: public ProtobufCBuffer {
+            std::vector<uint8_t> data;
+
+            VectorSink():
+                ProtobufCBuffer{_Append}
+            {
+            }
+
+            static
+            void _Append(ProtobufCBuffer* buffer, std::size_t length, const uint8_t* data)
+            {
+                auto* sink = static_cast<VectorSink*>(buffer);
+                sink->data.insert(sink->data.end(), data, data + length);
+            }
+        };
+
+        EncoderTestResult result;
+        const auto& base = *reinterpret_cast<const ProtobufCMessage*>(&msg);
+        result.matches_descriptor = Enc::Matches(*base.descriptor);
+
+        std::vector<uint8_t> expected(protobuf_c_message_get_packed_size(&base));
+        std::vector<uint8_t> packed(Enc::Size(msg));
+        DECLARE_CYCLE_COUNT_VAR(protobuf_c_start);
+        const std::size_t expected_length = protobuf_c_message_pack(&base, expected.data());
+        DECLARE_CYCLE_COUNT_VAR(protobuf_c_end);
+        DECLARE_CYCLE_COUNT_VAR(encoder_start);
+        const std::size_t packed_length = Enc::PackTo(msg, packed.data(), packed.size());
+        DECLARE_CYCLE_COUNT_VAR(encoder_end);
+        result.protobuf_c_cycles = protobuf_c_end - protobuf_c_start;
+        result.encoder_cycles = encoder_end - encoder_start;
+
+        VectorSink sink;
+        const std::size_t sink_length = Enc::PackTo(msg, &sink);
+        result.is_same = expected_length == expected.size() && packed_length == expected_length
+            && sink_length == expected_length && packed == expected && sink.data == expected;
+        return result;
+    }
+}
+#endif
+}
+}
+
+#define PROTO_FIELD_REQUIRED(id, codec, cls, attr) \
+    espp::proto::Required<id, espp::proto::codec, cls, decltype(cls::attr), &cls::attr>
+#define PROTO_FIELD_OPTIONAL(id, codec, cls, attr) \
+    espp::proto::Optional<id, espp::proto::codec, cls, decltype(cls::attr), &cls::attr, &cls::has_##attr>
+#define PROTO_FIELD_OPTIONAL_PTR(id, codec, cls, attr) \
+    espp::proto::OptionalPtr<id, espp::proto::codec, cls, decltype(cls::attr), &cls::attr>
+#define PROTO_FIELD(id, codec, cls, attr) \
+    espp::proto::Implicit<id, espp::proto::codec, cls, decltype(cls::attr), &cls::attr>
+#define PROTO_FIELD_REPEATED(id, codec, cls, attr) \
+    espp::proto::Repeated<id, espp::proto::codec, cls, std::remove_pointer<decltype(cls::attr)>::type, &cls::attr, &cls::n_##attr>
+#define PROTO_FIELD_PACKED(id, codec, cls, attr) \
+    espp::proto::Packed<id, espp::proto::codec, cls, std::remove_pointer<decltype(cls::attr)>::type, &cls::attr, &cls::n_##attr>
+
+/**
+ * Add FastPackedSize and FastPackTo to PROTO wrapper
+ *
+ * Example
+ *
+ *      using LampStateEncoder = espp::proto::Encoder<
+ *          PROTO_FIELD_OPTIONAL(1, UInt32, LampState, brightness),
+ *          PROTO_FIELD_OPTIONAL_PTR(2, String, LampState, name)
+ *      >;
+ *
+ *      PROTO(LampState, lamp_state)
+ *          PROTO_ENCODER(LampStateEncoder)
+ *          PROTO_VALUE(brightness)
+ *          PROTO_STR(name)
+ *      };
+ */
+#define PROTO_ENCODER(encoder) \
+    using Encoder = encoder; \
+    std::size_t FastPackedSize() const { return Encoder::Size(*this); } \
+    std::size_t FastPackTo(uint8_t* buffer, std::size_t length) const { return Encoder::PackTo(*this, buffer, length); } \
+    std::size_t FastPackTo(ProtobufCBuffer& sink) const { return Encoder::PackTo(*this, &sink); } \
+    /** Encoder field table matches generated descriptor */ \
+    bool CheckEncoder() const { return Encoder::Matches(*base.descriptor); } \
+    template<std::size_t size> bool FastPackTo(espp::StaticBuffer<size>& buffer) const { \
+        if(Encoder::Size(*this) > size) { buffer.Clear(); return false; } \
+        buffer.Resize(Encoder::Put(*this, buffer.writeData()) - buffer.writeData()); return true; \
+    }
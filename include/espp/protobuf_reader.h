@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#include "espp/buffer.h"
+#include "espp/utils/test.h"
+
+#ifdef ENABLE_TEST
+#include <protobuf-c/protobuf-c.h>
+#endif
+
+namespace espp {
+
+enum class ProtoWireType: uint8_t {
+    varint = 0,
+    fixed64 = 1,
+    length_delimited = 2,
+    fixed32 = 5,
+};
+
+/**
+ * Lazy reader of protobuf wire format.
+ *
+ * Iterates fields of packed message without unpacking and allocation.
+ * Strings, bytes and nested messages are slices of original buffer,
+ * so buffer must outlive reader and returned values.
+ *
+ * Example
+ *
+ *      ProtoReader reader(msg);
+ *      while(reader.Next()) {
+ *          switch(reader.field()) {
+ *              case 1:
+ *                  brightness = reader.uint32();
+ *                  break;
+ *              case 2:
+ *                  name = reader.bytes().str();
+ *                  break;
+ *          }
+ *      }
+ *      if(reader.hasError()) {
+ *          ...
+ *      }
+ */
+class ProtoReader {
+public:
+    explicit
+    ProtoReader(const Buffer& buffer):
+        ProtoReader(buffer.data(), buffer.length())
+    {
+    }
+
+    ProtoReader(const uint8_t* data, std::size_t length):
+        _current(data),
+        _end(data + length)
+    {
+    }
+
+    /** Move to next field. Return false at the end of message or on malformed data */
+    bool Next();
+
+    /** Move to next field with number. Return false if there is no such field */
+    bool Find(uint32_t field);
+
+    bool hasError() const
+    {
+        return _has_error;
+    }
+
+    uint32_t field() const
+    {
+        return _field;
+    }
+
+    ProtoWireType wireType() const
+    {
+        return _wire_type;
+    }
+
+    uint64_t varint() const
+    {
+        return _value;
+    }
+
+    uint32_t uint32() const
+    {
+        return static_cast<uint32_t>(_value);
+    }
+
+    int32_t int32() const
+    {
+        return static_cast<int32_t>(_value);
+    }
+
+    uint64_t uint64() const
+    {
+        return _value;
+    }
+
+    int64_t int64() const
+    {
+        return static_cast<int64_t>(_value);
+    }
+
+    int32_t sint32() const
+    {
+        return static_cast<int32_t>(static_cast<uint32_t>(_value) >> 1u) ^ -static_cast<int32_t>(_value & 1u);
+    }
+
+    int64_t sint64() const
+    {
+        return static_cast<int64_t>(_value >> 1u) ^ -static_cast<int64_t>(_value & 1u);
+    }
+
+    bool boolean() const
+    {
+        return _value != 0;
+    }
+
+    uint32_t fixed32() const
+    {
+        return static_cast<uint32_t>(_value);
+    }
+
+    int32_t sfixed32() const
+    {
+        return static_cast<int32_t>(_value);
+    }
+
+    uint64_t fixed64() const
+    {
+        return _value;
+    }
+
+    int64_t sfixed64() const
+    {
+        return static_cast<int64_t>(_value);
+    }
+
+    float float32() const
+    {
+        const auto value = fixed32();
+        float result;
+        std::memcpy(&result, &value, sizeof(result));
+        return result;
+    }
+
+    double float64() const
+    {
+        double result;
+        std::memcpy(&result, &_value, sizeof(result));
+        return result;
+    }
+
+    /** Bytes or string field as slice of original buffer. Empty before the first field */
+    Buffer bytes() const
+    {
+        // Buffer needs valid pointer even for empty slice
+        return {_value_data != nullptr ? _value_data : reinterpret_cast<const uint8_t*>(""), _value_length};
+    }
+
+    /** Reader of nested message */
+    ProtoReader nested() const
+    {
+        return {_value_data, _value_length};
+    }
+
+private:
+    const uint8_t* _current;
+    const uint8_t* const _end;
+    uint32_t _field = 0;
+    ProtoWireType _wire_type = ProtoWireType::varint;
+    uint64_t _value = 0;
+    const uint8_t* _value_data = nullptr;
+    std::size_t _value_length = 0;
+    bool _has_error = false;
+
+    bool _ReadVarint(uint64_t& value);
+
+    bool _Fail()
+    {
+        _has_error = true;
+        _current = _end;
+        return false;
+    }
+};
+
+#ifdef ENABLE_TEST
+namespace testing {
+    struct ProtoReaderBenchmark {
+        unsigned int fields = 0;        ///< fields visited by ProtoReader, 0 on error
+        uint32_t reader_cycles = 0;     ///< ProtoReader walks all fields and reads values
+        uint32_t unpack_cycles = 0;     ///< protobuf_c_message_unpack with heap and free_unpacked
+        uint32_t arena_cycles = 0;      ///< protobuf_c_message_unpack into ProtoArena
+    };
+
+    /** Min cycles of few runs for packed message of application */
+    ProtoReaderBenchmark testProtoReaderResult(const ProtobufCMessageDescriptor& descriptor, const Buffer& packed);
+}
+#endif
+
+}
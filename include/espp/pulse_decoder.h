@@ -0,0 +1,276 @@
+#pragma once
+
+#include <cstdint>
+
+/**
+ * Decoders of captured edges.
+ *
+ * All times are in CPU cycles.
+ */
+
+namespace espp {
+
+/**
+ * One edge: level of pin after edge and cycle count when it was seen
+ */
+struct Edge {
+    uint32_t ccount;
+    uint8_t pin;
+    uint8_t level;
+};
+
+/**
+ * Width of the last high and low pulses
+ */
+class PulseWidth {
+public:
+    void Feed(const Edge& edge)
+    {
+        if(_has_edge && edge.level != _level) {
+            const uint32_t width = edge.ccount - _ccount;
+            if(_level != 0) {
+                _high = width;
+            } else {
+                _low = width;
+            }
+        }
+        _has_edge = true;
+        _level = edge.level;
+        _ccount = edge.ccount;
+    }
+
+    uint32_t high() const
+    {
+        return _high;
+    }
+
+    uint32_t low() const
+    {
+        return _low;
+    }
+
+    uint32_t period() const
+    {
+        return _high + _low;
+    }
+
+    /** Duty cycle in 0.1% */
+    uint32_t duty_permille() const
+    {
+        return period() == 0 ? 0 : static_cast<uint32_t>(uint64_t(_high) * 1000 / period());
+    }
+
+private:
+    uint32_t _ccount = 0;
+    uint32_t _high = 0;
+    uint32_t _low = 0;
+    uint8_t _level = 0;
+    bool _has_edge = false;
+};
+
+/**
+ * Frequency by number of rising edges in measured window
+ */
+class FrequencyMeter {
+public:
+    void Feed(const Edge& edge)
+    {
+        if(edge.level == 0) {
+            return;
+        }
+        if(_count == 0) {
+            _first = edge.ccount;
+        }
+        _last = edge.ccount;
+        _count += 1;
+    }
+
+    uint32_t count() const
+    {
+        return _count;
+    }
+
+    /** Frequency in mHz. Need at least 2 rising edges */
+    uint32_t frequency_mhz(uint32_t cpu_hz) const
+    {
+        if(_count < 2 || _last == _first) {
+            return 0;
+        }
+        return static_cast<uint32_t>(uint64_t(_count - 1) * cpu_hz * 1000 / (_last - _first));
+    }
+
+    void Reset()
+    {
+        _count = 0;
+    }
+
+private:
+    uint32_t _first = 0;
+    uint32_t _last = 0;
+    uint32_t _count = 0;
+};
+
+/**
+ * Decoder of NEC-like pulse train (IR remote).
+ *
+ * Frame: 9 ms mark, 4.5 ms space, 32 bits LSB first.
+ * Bit: 562 us mark, then 562 us space for 0 or 1687 us for 1.
+ * Repeat: 9 ms mark, 2.25 ms space.
+ * Durations are accepted with 25% tolerance.
+ */
+class NecDecoder {
+public:
+    /**
+     * @param cpu_mhz CPU frequency, used to convert cycles
+     * @param active_low true if mark is low level (usual IR receiver)
+     */
+    explicit
+    NecDecoder(uint32_t cpu_mhz = 80, bool active_low = true):
+        _cycles_per_us(cpu_mhz),
+        _mark_level(active_low ? 0 : 1)
+    {
+    }
+
+    /** Return true when frame or repeat is decoded */
+    bool Feed(const Edge& edge)
+    {
+        const bool has_prev = _has_edge;
+        const uint32_t duration = edge.ccount - _ccount;
+        const bool is_mark = _level == _mark_level;
+        _has_edge = true;
+        _level = edge.level;
+        _ccount = edge.ccount;
+        if(!has_prev) {
+            return false;
+        }
+        return is_mark ? _OnMark(duration) : _OnSpace(duration);
+    }
+
+    uint32_t data() const
+    {
+        return _data;
+    }
+
+    uint8_t address() const
+    {
+        return static_cast<uint8_t>(_data);
+    }
+
+    /** 16 bit address of extended protocol */
+    uint16_t extended_address() const
+    {
+        return static_cast<uint16_t>(_data);
+    }
+
+    uint8_t command() const
+    {
+        return static_cast<uint8_t>(_data >> 16);
+    }
+
+    bool isRepeat() const
+    {
+        return _is_repeat;
+    }
+
+    /** Number of frames dropped due to invalid timing or checksum */
+    unsigned int errors() const
+    {
+        return _errors;
+    }
+
+private:
+    enum class State {
+        idle,
+        leader_mark,
+        leader_space,
+        bit_mark,
+        bit_space,
+    };
+
+    const uint32_t _cycles_per_us;
+    const uint8_t _mark_level;
+    State _state = State::idle;
+    uint32_t _ccount = 0;
+    uint32_t _shift = 0;
+    uint32_t _data = 0;
+    uint8_t _bits = 0;
+    uint8_t _level = 1;
+    bool _has_edge = false;
+    bool _is_repeat = false;
+    unsigned int _errors = 0;
+
+    bool _Is(uint32_t duration, uint32_t us) const
+    {
+        const uint32_t expected = us * _cycles_per_us;
+        const uint32_t tolerance = expected / 4;
+        return duration >= expected - tolerance && duration <= expected + tolerance;
+    }
+
+    bool _Fail()
+    {
+        if(_state != State::idle && _state != State::leader_mark) {
+            _errors += 1;
+        }
+        _state = State::idle;
+        return false;
+    }
+
+    bool _OnMark(uint32_t duration)
+    {
+        if(_Is(duration, 9000)) {
+            _state = State::leader_mark;
+            return false;
+        }
+        if(_state == State::bit_mark && _Is(duration, 562)) {
+            if(_bits == 32) {
+                // stop bit
+                _state = State::idle;
+                if((((_shift >> 16) ^ (_shift >> 24)) & 0xFF) != 0xFF) {
+                    _errors += 1;
+                    return false;
+                }
+                _data = _shift;
+                _is_repeat = false;
+                return true;
+            }
+            _state = State::bit_space;
+            return false;
+        }
+        return _Fail();
+    }
+
+    bool _OnSpace(uint32_t duration)
+    {
+        switch(_state) {
+            case State::leader_mark:
+                if(_Is(duration, 4500)) {
+                    _state = State::bit_mark;
+                    _shift = 0;
+                    _bits = 0;
+                    return false;
+                }
+                if(_Is(duration, 2250)) {
+                    _state = State::idle;
+                    _is_repeat = true;
+                    return true;
+                }
+                return _Fail();
+            case State::bit_space:
+                if(_Is(duration, 562)) {
+                    _bits += 1;
+                } else if(_Is(duration, 1687)) {
+                    _shift |= uint32_t(1) << _bits;
+                    _bits += 1;
+                } else {
+                    return _Fail();
+                }
+                _state = State::bit_mark;
+                return false;
+            default:
+                // gap between frames
+                return false;
+        }
+    }
+};
+
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+namespace espp {
+
+/**
+ * Edge schedule of one software PWM period.
+ *
+ * All channels with non zero duty go high at period start and go low at their own time.
+ * Channels which go low at the same time (or closer than minimal step) are merged into one step,
+ * so each step is one out_w1tc write.
+ */
+class PwmSchedule {
+public:
+    static const std::size_t MAX_CHANNELS = 16;
+
+    struct Step {
+        uint32_t at;        ///< time from period start
+        uint32_t mask;      ///< pins which go low
+    };
+
+    /**
+     * @param masks GPIO mask of each channel
+     * @param on_times time of high level of each channel. Value >= period is always high
+     * @param min_step steps closer than it are merged into earlier one
+     */
+    void Build(const uint32_t* masks, const uint32_t* on_times, std::size_t count,
+               uint32_t period, uint32_t min_step = 0)
+    {
+        _period = period;
+        _high_mask = 0;
+        _low_mask = 0;
+        _size = 0;
+        for(std::size_t channel = 0; channel < count && channel < MAX_CHANNELS; ++channel) {
+            const uint32_t on_time = on_times[channel];
+            if(on_time == 0) {
+                _low_mask |= masks[channel];
+                continue;
+            }
+            _high_mask |= masks[channel];
+            if(on_time < period) {
+                // timer can't fire sooner than min_step after period start
+                _Insert(on_time < min_step ? min_step : on_time, masks[channel]);
+            }
+        }
+        _Merge(min_step);
+    }
+
+    uint32_t period() const
+    {
+        return _period;
+    }
+
+    /** Pins which go high at period start */
+    uint32_t high_mask() const
+    {
+        return _high_mask;
+    }
+
+    /** Pins which are low during whole period */
+    uint32_t low_mask() const
+    {
+        return _low_mask;
+    }
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+
+    const Step& operator[](std::size_t idx) const
+    {
+        return _steps[idx];
+    }
+
+    /** Time from step idx to the next step or to period end */
+    uint32_t delay_after(std::size_t idx) const
+    {
+        return (idx + 1 < _size ? _steps[idx + 1].at : _period) - _steps[idx].at;
+    }
+
+    /** Time from period start to the first step or to period end */
+    uint32_t first_delay() const
+    {
+        return _size == 0 ? _period : _steps[0].at;
+    }
+
+private:
+    std::array<Step, MAX_CHANNELS> _steps;
+    std::size_t _size = 0;
+    uint32_t _period = 0;
+    uint32_t _high_mask = 0;
+    uint32_t _low_mask = 0;
+
+    void _Insert(uint32_t at, uint32_t mask)
+    {
+        // insertion sort, there are only few channels
+        std::size_t idx = _size;
+        while(idx > 0 && _steps[idx - 1].at > at) {
+            _steps[idx] = _steps[idx - 1];
+            --idx;
+        }
+        _steps[idx] = {at, mask};
+        _size += 1;
+    }
+
+    void _Merge(uint32_t min_step)
+    {
+        if(_size == 0) {
+            return;
+        }
+        // equal times are merged even without min_step
+        const uint32_t min_gap = min_step == 0 ? 1 : min_step;
+        std::size_t last = 0;
+        for(std::size_t idx = 1; idx < _size; ++idx) {
+            if(_steps[idx].at - _steps[last].at < min_gap) {
+                _steps[last].mask |= _steps[idx].mask;
+            } else {
+                _steps[++last] = _steps[idx];
+            }
+        }
+        _size = last + 1;
+        // period end acts as step, so too short last step is merged into the next start
+        while(_size > 0 && _period - _steps[_size - 1].at < min_step) {
+            _size -= 1;
+        }
+    }
+};
+
+}
@@ -0,0 +1,398 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <atomic>
+#include <algorithm>
+
+#include "espp/critical_section.h"
+
+namespace espp {
+
+/**
+ * Wake consumer task by task notification.
+ *
+ * Consumer registers itself only while it waits, so producers don't notify without need.
+ */
+class QueueWaiter {
+public:
+    template<class Predicate>
+    bool Wait(Predicate is_ready, TickType_t ticks)
+    {
+        if(is_ready()) {
+            return true;
+        }
+        _waiter.store(xTaskGetCurrentTaskHandle(), std::memory_order_seq_cst);
+        const TickType_t start = xTaskGetTickCount();
+        TickType_t remain = ticks;
+        // producer could push before waiter was stored, and notification left
+        // by earlier push can wake before anything is ready, so check again
+        while(!is_ready()) {
+            ulTaskNotifyTake(pdTRUE, remain);
+            if(ticks != portMAX_DELAY) {
+                const TickType_t elapsed = xTaskGetTickCount() - start;
+                if(elapsed >= ticks) {
+                    break;
+                }
+                remain = ticks - elapsed;
+            }
+        }
+        _waiter.store(nullptr, std::memory_order_relaxed);
+        return is_ready();
+    }
+
+    void Notify()
+    {
+        const TaskHandle_t waiter = _waiter.load(std::memory_order_seq_cst);
+        if(waiter != nullptr) {
+            xTaskNotifyGive(waiter);
+        }
+    }
+
+    void NotifyFromISR()
+    {
+        const TaskHandle_t waiter = _waiter.load(std::memory_order_seq_cst);
+        if(waiter != nullptr) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(waiter, &woken);
+            if(woken == pdTRUE) {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
+
+private:
+    std::atomic<TaskHandle_t> _waiter{nullptr};
+};
+
+/**
+ * Bounded single producer single consumer queue without locks.
+ *
+ * Producer can be task or ISR. Indexes grow freely and are masked by capacity.
+ *
+ * @tparam T item type (should be trivially copyable)
+ * @tparam capacity power of two
+ */
+template<class T, std::size_t capacity>
+class SpscQueue {
+public:
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be power of two");
+
+    SpscQueue() = default;
+
+    SpscQueue(const SpscQueue&) = delete;
+
+    std::size_t size() const
+    {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    // Producer
+
+    /**
+     * Claim contiguous space for writing.
+     * @param count number of available items (can be less than free space due to wrap)
+     */
+    T* ClaimWrite(std::size_t& count)
+    {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const uint32_t free = capacity - (tail - _head.load(std::memory_order_acquire));
+        const uint32_t idx = tail & MASK;
+        count = std::min<std::size_t>(free, capacity - idx);
+        return &_items[idx];
+    }
+
+    void CommitWrite(std::size_t count)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        _waiter.Notify();
+    }
+
+    void CommitWriteFromISR(std::size_t count)
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        _waiter.NotifyFromISR();
+    }
+
+    /** Return number of pushed items */
+    std::size_t Push(const T* items, std::size_t count)
+    {
+        const auto result = _Write(items, count);
+        CommitWrite(result);
+        return result;
+    }
+
+    std::size_t PushFromISR(const T* items, std::size_t count)
+    {
+        const auto result = _Write(items, count);
+        CommitWriteFromISR(result);
+        return result;
+    }
+
+    bool Push(const T& item)
+    {
+        return Push(&item, 1) == 1;
+    }
+
+    bool PushFromISR(const T& item)
+    {
+        return PushFromISR(&item, 1) == 1;
+    }
+
+    // Consumer
+
+    const T* ClaimRead(std::size_t& count)
+    {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t used = _tail.load(std::memory_order_acquire) - head;
+        const uint32_t idx = head & MASK;
+        count = std::min<std::size_t>(used, capacity - idx);
+        return &_items[idx];
+    }
+
+    void CommitRead(std::size_t count)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    /** Return number of popped items */
+    std::size_t Pop(T* items, std::size_t count)
+    {
+        std::size_t result = 0;
+        while(result < count) {
+            std::size_t available;
+            const T* data = ClaimRead(available);
+            if(available == 0) {
+                break;
+            }
+            available = std::min(available, count - result);
+            std::copy(data, data + available, items + result);
+            CommitRead(available);
+            result += available;
+        }
+        return result;
+    }
+
+    bool Pop(T& item)
+    {
+        return Pop(&item, 1) == 1;
+    }
+
+    /** Wait until queue isn't empty. Only consumer can wait */
+    bool Wait(TickType_t ticks = portMAX_DELAY)
+    {
+        return _waiter.Wait([this]() { return !empty(); }, ticks);
+    }
+
+private:
+    static const uint32_t MASK = capacity - 1;
+
+    std::array<T, capacity> _items;
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    QueueWaiter _waiter;
+
+    std::size_t _Write(const T* items, std::size_t count)
+    {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        const std::size_t free = capacity - (tail - _head.load(std::memory_order_acquire));
+        count = std::min(count, free);
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            _items[(tail + idx) & MASK] = items[idx];
+        }
+        return count;
+    }
+};
+
+/**
+ * Bounded multiple producers single consumer queue.
+ *
+ * Producers reserve slots in short critical section (ESP8266 doesn't have CAS)
+ * and write outside of it. Every slot has sequence which marks it as ready,
+ * so consumer doesn't lock.
+ *
+ * @tparam T item type (should be trivially copyable)
+ * @tparam capacity power of two
+ */
+template<class T, std::size_t capacity>
+class MpscQueue {
+public:
+    static_assert(capacity > 0 && (capacity & (capacity - 1)) == 0, "capacity must be power of two");
+
+    MpscQueue() = default;
+
+    MpscQueue(const MpscQueue&) = delete;
+
+    /** Number of claimed and not yet popped items. Use only for statistics */
+    std::size_t size() const
+    {
+        uint32_t tail;
+        {
+            CriticalSection lock;
+            tail = _tail;
+        }
+        return tail - _head.load(std::memory_order_acquire);
+    }
+
+    bool empty() const
+    {
+        return !_IsReady(_head.load(std::memory_order_relaxed));
+    }
+
+    // Producers
+
+    /**
+     * Reserve count slots. Slots are written after claim and marked ready by Commit.
+     * @return first reserved position or false if there is no space
+     */
+    bool Claim(std::size_t count, uint32_t& position)
+    {
+        CriticalSection lock;
+        if(capacity - (_tail - _head.load(std::memory_order_acquire)) < count) {
+            _dropped += 1;
+            return false;
+        }
+        position = _tail;
+        _tail += count;
+        return true;
+    }
+
+    T& item(uint32_t position)
+    {
+        return _cells[position & MASK].item;
+    }
+
+    void Commit(uint32_t position, std::size_t count)
+    {
+        _MarkReady(position, count);
+        _waiter.Notify();
+    }
+
+    void CommitFromISR(uint32_t position, std::size_t count)
+    {
+        _MarkReady(position, count);
+        _waiter.NotifyFromISR();
+    }
+
+    /** Push all items or nothing */
+    bool Push(const T* items, std::size_t count)
+    {
+        uint32_t position;
+        if(!Claim(count, position)) {
+            return false;
+        }
+        _Write(position, items, count);
+        Commit(position, count);
+        return true;
+    }
+
+    bool PushFromISR(const T* items, std::size_t count)
+    {
+        uint32_t position;
+        if(!Claim(count, position)) {
+            return false;
+        }
+        _Write(position, items, count);
+        CommitFromISR(position, count);
+        return true;
+    }
+
+    bool Push(const T& item)
+    {
+        return Push(&item, 1);
+    }
+
+    bool PushFromISR(const T& item)
+    {
+        return PushFromISR(&item, 1);
+    }
+
+    /** Number of rejected pushes due to full queue */
+    unsigned int dropped() const
+    {
+        return _dropped;
+    }
+
+    // Consumer
+
+    /** Claim contiguous ready items */
+    const T* ClaimRead(std::size_t& count)
+    {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        const uint32_t idx = head & MASK;
+        count = 0;
+        while(idx + count < capacity && _IsReady(head + count)) {
+            count += 1;
+        }
+        return &_cells[idx].item;
+    }
+
+    void CommitRead(std::size_t count)
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+    }
+
+    std::size_t Pop(T* items, std::size_t count)
+    {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        std::size_t result = 0;
+        while(result < count && _IsReady(head + result)) {
+            items[result] = _cells[(head + result) & MASK].item;
+            result += 1;
+        }
+        CommitRead(result);
+        return result;
+    }
+
+    bool Pop(T& item)
+    {
+        return Pop(&item, 1) == 1;
+    }
+
+    bool Wait(TickType_t ticks = portMAX_DELAY)
+    {
+        return _waiter.Wait([this]() { return !empty(); }, ticks);
+    }
+
+private:
+    static const uint32_t MASK = capacity - 1;
+
+    struct Cell {
+        std::atomic<uint32_t> ready{0};   ///< position + 1 when item is written
+        T item;
+    };
+
+    std::array<Cell, capacity> _cells;
+    std::atomic<uint32_t> _head{0};
+    uint32_t _tail = 0;
+    unsigned int _dropped = 0;
+    QueueWaiter _waiter;
+
+    bool _IsReady(uint32_t position) const
+    {
+        return _cells[position & MASK].ready.load(std::memory_order_acquire) == position + 1;
+    }
+
+    void _Write(uint32_t position, const T* items, std::size_t count)
+    {
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            item(position + idx) = items[idx];
+        }
+    }
+
+    void _MarkReady(uint32_t position, std::size_t count)
+    {
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            _cells[(position + idx) & MASK].ready.store(position + idx + 1, std::memory_order_release);
+        }
+    }
+};
+
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+#include <array>
+
+#include "espp/gpio.h"
+#include "espp/pwm_schedule.h"
+
+namespace espp {
+
+/**
+ * Software PWM of up to 16 GPIO channels driven by hardware timer.
+ *
+ * Timer interrupt is scheduled only for merged edges of PwmSchedule.
+ * Duty is changed in second schedule which is swapped at period boundary, so there are no glitches.
+ * Hardware timer is single, so only one SoftPwm can be started.
+ */
+class SoftPwm {
+public:
+    static const std::size_t MAX_CHANNELS = PwmSchedule::MAX_CHANNELS;
+    /** Edges closer than it are merged. Covers ISR entry and exit */
+    static const uint32_t MIN_STEP_US = 10;
+    static const uint8_t MAX_DUTY = 0xFF;
+
+    explicit
+    SoftPwm(uint32_t period_us = 1000):
+        _period_us(period_us)
+    {
+        _masks.fill(0);
+        _on_times.fill(0);
+    }
+
+    SoftPwm(const SoftPwm&) = delete;
+
+    /** Return channel index or -1 if all channels are used. Pin is switched to output */
+    int AddChannel(GpioPin& pin);
+
+    /** Duty from 0 to MAX_DUTY. It's applied from the next period */
+    void SetDuty(int channel, uint8_t duty);
+
+    uint8_t duty(int channel) const
+    {
+        return _duties[channel];
+    }
+
+    bool Start();
+
+    void Stop();
+
+    uint32_t periods() const
+    {
+        return _periods;
+    }
+
+private:
+    /** Timer ticks per microsecond with 80 MHz APB clock and divider 16 */
+    static const uint32_t TICKS_PER_US = 5;
+
+    std::array<uint32_t, MAX_CHANNELS> _masks;
+    std::array<uint32_t, MAX_CHANNELS> _on_times;
+    std::array<uint8_t, MAX_CHANNELS> _duties = {};
+    std::size_t _channels = 0;
+    const uint32_t _period_us;
+
+    PwmSchedule _schedules[2];
+    uint8_t _active = 0;
+    volatile bool _pending = false;
+    std::size_t _step = 0;
+    uint32_t _periods = 0;
+    bool _is_started = false;
+
+    void _Commit();
+
+    static
+    void _Isr(void* arg);
+};
+
+}
@@ -3,6 +3,7 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 
+#include <array>
 #include <type_traits>
 
 #include "espp/log.h"
@@ -27,23 +28,32 @@ public:
 
 class Task: public TaskBase {
 public:
+    static const configSTACK_DEPTH_TYPE DEFAULT_STACK_DEPTH = 4096;
+
     explicit
-    Task(UBaseType_t priority = 0):
+    Task(UBaseType_t priority = 0, configSTACK_DEPTH_TYPE stack_depth = DEFAULT_STACK_DEPTH):
         _handle(),
-        _priority(priority)
+        _priority(priority),
+        _stack_depth(stack_depth)
     {
         vTaskSetThreadLocalStoragePointer(nullptr, static_cast<BaseType_t>(LTS::TASK), this);
     }
 
     explicit
-    Task(const char* name):
+    Task(const char* name, UBaseType_t priority = 0, configSTACK_DEPTH_TYPE stack_depth = DEFAULT_STACK_DEPTH):
         _handle(),
-        _priority(0),
+        _priority(priority),
+        _stack_depth(stack_depth),
         _name(name)
     {
         vTaskSetThreadLocalStoragePointer(nullptr, static_cast<BaseType_t>(LTS::TASK), this);
     }
 
+    ~Task()
+    {
+        _Unregister();
+    }
+
     UBaseType_t priority() const
     {
         return _priority;
@@ -51,7 +61,13 @@ public:
 
     configSTACK_DEPTH_TYPE stack_depth() const
     {
-        return 4096;
+        return _stack_depth;
+    }
+
+    /** Min free stack seen by TaskStackMonitor. Same units as stack_depth */
+    UBaseType_t min_free_stack() const
+    {
+        return _min_free_stack;
     }
 
     TaskHandle_t& handle()
@@ -59,7 +75,7 @@ public:
         return _handle;
     }
 
-    const char* name()
+    const char* name() const
     {
         if (_name == nullptr) {
             return "";
@@ -78,25 +94,168 @@ public:
         InstTask& task = *reinterpret_cast<InstTask*>(pTask);
         task.init_run();
         task.run();
+        task._Unregister();
         vTaskDelete(NULL);
     }
 
+    static bool _Create(Task& task, TaskFunction_t function, void* param)
+    {
+        return pdPASS == xTaskCreate(function, task.name(), task.stack_depth(), param, task.priority(), &task.handle());
+    }
+
     template<class InstTask>
-    static void Start(InstTask& task)
+    static bool Start(InstTask& task)
     {
         static_assert(std::is_base_of<Task, InstTask>::value, "expect Task");
         auto run_func = Task::_task_function<InstTask>;
         auto param = reinterpret_cast<void*>(&task);
-        xTaskCreate(run_func, task.name(), task.stack_depth(), param, task.priority(), &task.handle());
+        task._Register();
+        if(!InstTask::_Create(task, run_func, param)) {
+            ERROR << "Can't start task" << task.name();
+            task._Unregister();
+            return false;
+        }
+        return true;
+    }
+
+    /** Memory reserved by all StaticTask objects */
+    static
+    std::size_t static_reserved_memory()
+    {
+        return _StaticReservedMemory();
     }
 
 
 protected:
     TaskHandle_t _handle;
     UBaseType_t _priority;
+    configSTACK_DEPTH_TYPE _stack_depth;
+    const char* _name = nullptr;
 
 private:
-    const char* _name = nullptr;
+    friend class TaskStackMonitor;
+
+    UBaseType_t _min_free_stack = 0;
+    bool _is_stack_sampled = false;
+    Task* _next_task = nullptr;
+
+    template<configSTACK_DEPTH_TYPE stackSize>
+    friend class StaticTask;
+
+    static
+    Task*& _FirstTask()
+    {
+        static Task* first = nullptr;
+        return first;
+    }
+
+    static
+    std::size_t& _StaticReservedMemory()
+    {
+        static std::size_t total = 0;
+        return total;
+    }
+
+    void _Register();
+
+    void _Unregister();
+};
+
+#if configSUPPORT_STATIC_ALLOCATION
+/**
+ * Task with stack and TCB allocated inside object.
+ *
+ * Started by xTaskCreateStatic, so start can't fail due to heap.
+ * Requires configSUPPORT_STATIC_ALLOCATION.
+ *
+ * @tparam stackSize stack depth in StackType_t
+ */
+template<configSTACK_DEPTH_TYPE stackSize>
+class StaticTask: public Task {
+public:
+    explicit
+    StaticTask(UBaseType_t priority = 0):
+        Task(priority, stackSize)
+    {
+        _StaticReservedMemory() += _reserved_memory;
+    }
+
+    explicit
+    StaticTask(const char* name, UBaseType_t priority = 0):
+        Task(name, priority, stackSize)
+    {
+        _StaticReservedMemory() += _reserved_memory;
+    }
+
+    StaticTask(const StaticTask&) = delete;
+
+    ~StaticTask()
+    {
+        _StaticReservedMemory() -= _reserved_memory;
+    }
+
+    static bool _Create(Task& task, TaskFunction_t function, void* param)
+    {
+        auto& self = static_cast<StaticTask&>(task);
+        self._handle = xTaskCreateStatic(function, self.name(), stackSize, param, self.priority(),
+                                         self._stack.data(), &self._tcb);
+        return self._handle != nullptr;
+    }
+
+private:
+    static const std::size_t _reserved_memory = sizeof(StackType_t) * stackSize + sizeof(StaticTask_t);
+
+    std::array<StackType_t, stackSize> _stack;
+    StaticTask_t _tcb;
+};
+#endif
+
+/**
+ * Periodically record stack high water mark of all started espp::Task.
+ *
+ * Report shows headroom of each task and recommended stack depth,
+ * so stack depths can be tuned from real runs.
+ */
+class TaskStackMonitor: public Task {
+public:
+    explicit
+    TaskStackMonitor(uint32_t period_ms = 10000, bool report = true):
+        Task("stack_monitor", tskIDLE_PRIORITY + 1, 2048),
+        _period_ms(period_ms),
+        _report(report)
+    {
+    }
+
+    void run()
+    {
+        for(;;) {
+            Sample();
+            if(_report) {
+                Report();
+            }
+            DelayMs(_period_ms);
+        }
+    }
+
+    /** Update min free stack of all tasks */
+    static
+    void Sample();
+
+    /** Log headroom and recommended depth of all sampled tasks */
+    static
+    void Report();
+
+    /** Recommended depth: used stack plus 25% and 256 rounded up to 256 */
+    static
+    configSTACK_DEPTH_TYPE RecommendedDepth(const Task& task)
+    {
+        const UBaseType_t used = task.stack_depth() - task.min_free_stack();
+        return ((used + used / 4 + 256 + 255) / 256) * 256;
+    }
+
+private:
+    const uint32_t _period_ms;
+    const bool _report;
 };
 
 }
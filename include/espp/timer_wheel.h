@@ -0,0 +1,140 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+
+#include "espp/task.h"
+
+namespace espp {
+
+/**
+ * Timer node of TimerWheel. Owned by user, so wheel doesn't allocate.
+ *
+ * Callback is called in TimerWheel task.
+ */
+class Timer {
+public:
+    using Callback = void (*)(void* arg);
+
+    explicit
+    Timer(Callback callback, void* arg = nullptr):
+        _callback(callback),
+        _arg(arg)
+    {
+    }
+
+    Timer(const Timer&) = delete;
+
+    bool isArmed() const
+    {
+        return _pprev != nullptr;
+    }
+
+private:
+    friend class TimerWheel;
+
+    Timer* _next = nullptr;
+    Timer** _pprev = nullptr;
+    TickType_t _expires = 0;
+    TickType_t _period = 0;
+    const Callback _callback;
+    void* const _arg;
+};
+
+/**
+ * Hierarchical timer wheel executed by one task.
+ *
+ * 4 levels of 64 slots cover 2^24 ticks, longer delays are cascaded again.
+ * Arm and Cancel are O(1) and can be called from ISR.
+ * All timers expired on same tick are fired as one batch.
+ */
+class TimerWheel: public Task {
+public:
+    explicit
+    TimerWheel(const char* name = "timers", UBaseType_t priority = 2,
+               configSTACK_DEPTH_TYPE stack_depth = 2048):
+        Task(name, priority, stack_depth),
+        _slots()
+    {
+    }
+
+    TimerWheel(const TimerWheel&) = delete;
+
+    /** (Re)arm timer. Zero period means one-shot timer */
+    void Arm(Timer& timer, uint32_t delay_ms, uint32_t period_ms = 0)
+    {
+        _Arm(timer, xTaskGetTickCount(), pdMS_TO_TICKS(delay_ms), pdMS_TO_TICKS(period_ms));
+        if(_handle != nullptr) {
+            xTaskNotifyGive(_handle);
+        }
+    }
+
+    void ArmFromISR(Timer& timer, uint32_t delay_ms, uint32_t period_ms = 0)
+    {
+        _Arm(timer, xTaskGetTickCountFromISR(), pdMS_TO_TICKS(delay_ms), pdMS_TO_TICKS(period_ms));
+        if(_handle != nullptr) {
+            BaseType_t woken = pdFALSE;
+            vTaskNotifyGiveFromISR(_handle, &woken);
+            if(woken == pdTRUE) {
+                portYIELD_FROM_ISR();
+            }
+        }
+    }
+
+    /** Can be called from ISR or from timer callback */
+    void Cancel(Timer& timer);
+
+    void run();
+
+    /**
+     * Fire timers expired until now.
+     *
+     * Return false if no timer is armed, so there is no deadline.
+     * Otherwise next is set to tick when wheel has to be advanced again.
+     */
+    bool Advance(TickType_t now, TickType_t& next);
+
+    unsigned int armed() const
+    {
+        return _armed;
+    }
+
+    unsigned int fired() const
+    {
+        return _fired;
+    }
+
+    unsigned int max_batch() const
+    {
+        return _max_batch;
+    }
+
+private:
+    static const unsigned int LEVEL_BITS = 6;
+    static const unsigned int SLOTS = 1u << LEVEL_BITS;
+    static const unsigned int SLOT_MASK = SLOTS - 1;
+    static const unsigned int LEVELS = 4;
+
+    std::array<Timer*, SLOTS * LEVELS> _slots;
+    Timer* _expired = nullptr;
+    TickType_t _next_tick = 0;
+    unsigned int _armed = 0;
+    unsigned int _fired = 0;
+    unsigned int _max_batch = 0;
+
+    void _Arm(Timer& timer, TickType_t now, TickType_t delay, TickType_t period);
+
+    void _Insert(Timer& timer);
+
+    void _Link(Timer*& head, Timer& timer);
+
+    void _Unlink(Timer& timer);
+
+    bool _Cascade(unsigned int level);
+
+    void _Fire();
+};
+
+}
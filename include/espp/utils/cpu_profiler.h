@@ -0,0 +1,114 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include <array>
+#include <string>
+
+#include "espp/log.h"
+
+namespace espp {
+
+/**
+ * Sampling CPU profiler.
+ *
+ * OnTick has to be called from tick hook (define ESPP_CPU_PROFILER_TICK_HOOK to use
+ * provided vApplicationTickHook). Cycles between ticks are attributed to the task
+ * which was interrupted by tick. Cycles spent in ISRs wrapped by IsrScope are
+ * accounted separately. Counters are 64 bit, so snapshots can be taken rarely
+ * (32 bit ccount wraps after 53 s at 80 MHz).
+ *
+ * Interrupted PCs are counted in fixed histogram. With ESPP_CPU_PROFILER_PC OnTick reads PC
+ * from exception frame which port saved at top of interrupted task stack. Otherwise
+ * (or for other sample sources like timer ISR) call SamplePc. Histogram is dumped by AppendPcTo
+ * and symbolized on host by tools/symbolize_pc.py with application ELF.
+ */
+class CpuProfiler {
+public:
+    static const std::size_t MAX_TASKS = 16;
+    static const std::size_t NAME_LENGTH = 16;
+    static const std::size_t PC_SLOTS = 128;
+    /** Samples in same 16 bytes of code are counted together */
+    static const uint32_t PC_MASK = ~uint32_t(0xF);
+
+    struct TaskUsage {
+        TaskHandle_t handle;
+        char name[NAME_LENGTH];
+        uint64_t cycles;
+        bool is_idle;
+    };
+
+    struct Snapshot {
+        std::array<TaskUsage, MAX_TASKS> tasks;
+        std::size_t task_count;
+        uint64_t total_cycles;
+        uint64_t isr_cycles;
+        uint64_t other_cycles;      ///< tasks which don't fit into table
+
+        /** CPU usage in 0.1% */
+        uint32_t permille(uint64_t cycles) const
+        {
+            return total_cycles == 0 ? 0 : static_cast<uint32_t>(cycles * 1000 / total_cycles);
+        }
+
+        uint64_t idle_cycles() const;
+
+        /** Append text report. Can be used as MQTT payload or HTTP response */
+        void AppendTo(std::string& out) const;
+    };
+
+    struct PcCount {
+        uint32_t pc;
+        uint32_t count;
+    };
+
+    struct PcHistogram {
+        std::array<PcCount, PC_SLOTS> slots;    ///< open addressing, zero pc is free slot
+        uint32_t samples;
+        uint32_t dropped;                       ///< samples which didn't fit into table
+    };
+
+    /** Called from tick hook */
+    static
+    void OnTick();
+
+    /** Count interrupted PC. Called from ISR or tick hook */
+    static
+    void SamplePc(uint32_t pc);
+
+    static
+    void IsrEnter();
+
+    static
+    void IsrExit();
+
+    /** Account ISR cycles in scope */
+    struct IsrScope {
+        IsrScope()
+        {
+            IsrEnter();
+        }
+
+        ~IsrScope()
+        {
+            IsrExit();
+        }
+    };
+
+    /** Copy counters collected since previous reset */
+    static
+    Snapshot TakeSnapshot(bool reset = true);
+
+    /** Histogram is ~1 KB, so it's copied to caller storage instead of stack */
+    static
+    void TakePcHistogram(PcHistogram& out, bool reset = true);
+
+    /** Append "0x<pc> <count>" lines for tools/symbolize_pc.py */
+    static
+    void AppendPcTo(const PcHistogram& histogram, std::string& out);
+};
+
+const Log& operator<<(const Log& log, const CpuProfiler::Snapshot& snapshot);
+
+}
@@ -2,10 +2,13 @@
 
 #include <esp_wifi.h>
 
+#include <atomic>
+
 #include <espp/task.h>
 #include <espp/mutex.h>
 #include <espp/log.h>
 #include <espp/buffer.h>
+#include <espp/wifi_status.h>
 
 namespace lamp {
 
@@ -17,17 +20,7 @@ using espp::Data;
  */
 class WiFi: espp::TaskBase{
 public:
-    enum class State{
-        none,                // -> wait_start
-        started,             // -> wait_connect
-        connected,           // -> started
-        wait_start,          // -> started, wait_start_connect
-        wait_connect,        // -> connected
-        wait_start_connect,  // -> wait_connect, wait_start
-    };
-
-    State _state = State::none;
-    bool _hasIp = false;
+    using State = WiFiStatus::State;
 
     WiFi();
 
@@ -45,24 +38,32 @@ public:
         return _isStation;
     }
 
+    /** State and IP flag are read from one atomic word, so readers never wait */
+    State state() const
+    {
+        return _status.state();
+    }
+
     bool isStarted() const
     {
-        return _state != State::none && _state != State::wait_start && _state != State::wait_start_connect;
+        const State state = this->state();
+        return state != State::none && state != State::wait_start && state != State::wait_start_connect;
     }
 
     bool isStationConnected() const
     {
-        return _state == State::connected;
+        return state() == State::connected;
     }
 
     bool isStationConnecting() const
     {
-        return _state == State::wait_connect || _state == State::wait_start_connect;
+        const State state = this->state();
+        return state == State::wait_connect || state == State::wait_start_connect;
     }
 
     bool hasStationIp() const
     {
-        return _hasIp;
+        return _status.hasIp();
     }
 
     Data accessPointSsid() const;
@@ -84,10 +85,13 @@ public:
 
 private:
     using Mutex = espp::Mutex<pdMS_TO_TICKS(100)>;
-    mutable Mutex _mutex;
+
+    /** Serializes configuration and commands. Event handlers change state without it */
+    mutable Mutex _mutex{"wifi"};
+    WiFiStatus _status;
     bool _isScan = false;
-    bool _isStation = false;
-    bool _isAccessPoint = false;
+    std::atomic<bool> _isStation{false};
+    std::atomic<bool> _isAccessPoint{false};
 
     static
     esp_err_t StaticEventHandler(void* context, system_event_t* event);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+#include "espp/critical_section.h"
+
+namespace lamp {
+
+/**
+ * WiFi state and station IP flag packed into one atomic word.
+ *
+ * Readers never wait and always see consistent pair. Writers change the word
+ * by compare-and-set transitions in short critical section (lx106 has no
+ * compare-and-swap instruction).
+ */
+class WiFiStatus {
+public:
+    enum class State{
+        none,                // -> wait_start
+        started,             // -> wait_connect
+        connected,           // -> started
+        wait_start,          // -> started, wait_start_connect
+        wait_connect,        // -> connected
+        wait_start_connect,  // -> wait_connect, wait_start
+    };
+
+    State state() const
+    {
+        return _StateOf(_word.load());
+    }
+
+    bool hasIp() const
+    {
+        return (_word.load() & _HAS_IP) != 0;
+    }
+
+    /** Change state if it's equal to from. IP flag is cleared if clearIp is set */
+    bool Transit(State from, State to, bool clearIp = false)
+    {
+        espp::CriticalSection lock;
+        uint32_t word = _word.load();
+        if(_StateOf(word) != from) {
+            return false;
+        }
+        word = (word & ~_STATE_MASK) | static_cast<uint32_t>(to);
+        if(clearIp) {
+            word &= ~_HAS_IP;
+        }
+        _word.store(word);
+        return true;
+    }
+
+    /** Set IP flag if state is equal to from */
+    bool SetIp(State from)
+    {
+        espp::CriticalSection lock;
+        const uint32_t word = _word.load();
+        if(_StateOf(word) != from) {
+            return false;
+        }
+        _word.store(word | _HAS_IP);
+        return true;
+    }
+
+    void ClearIp()
+    {
+        espp::CriticalSection lock;
+        _word.store(_word.load() & ~_HAS_IP);
+    }
+
+    /** Back to none without IP */
+    void Reset()
+    {
+        _word.store(static_cast<uint32_t>(State::none));
+    }
+
+private:
+    static const uint32_t _STATE_MASK = 0xFF;
+    static const uint32_t _HAS_IP = 0x100;
+
+    std::atomic<uint32_t> _word{static_cast<uint32_t>(State::none)};
+
+    static
+    State _StateOf(uint32_t word)
+    {
+        return static_cast<State>(word & _STATE_MASK);
+    }
+};
+
+}
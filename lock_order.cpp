@@ -0,0 +1,185 @@
+#include "espp/lock_order.h"
+#include "espp/critical_section.h"
+#include "espp/log.h"
+#include "espp/lts.h"
+
+#include <string>
+
+#include "esp8266/eagle_soc.h"
+
+// LTS::LOCK_ORDER slot exists only with the check
+#ifdef ESPP_LOCK_ORDER_CHECK
+
+namespace espp {
+
+namespace {
+
+static_assert(static_cast<int>(LTS::LOCK_ORDER) < configNUM_THREAD_LOCAL_STORAGE_POINTERS,
+              "ESPP_LOCK_ORDER_CHECK needs one more thread local storage pointer");
+
+using HeldLocks = Lts<uintptr_t, LTS::LOCK_ORDER>;
+
+const char* _names[LockOrder::MAX_LOCKS] = {};
+uint8_t _count = 0;
+uint32_t _after[LockOrder::MAX_LOCKS] = {};     ///< edge a -> b: b was acquired while a was held
+uint32_t _reach[LockOrder::MAX_LOCKS] = {};     ///< transitive closure of _after
+uint32_t _reported[LockOrder::MAX_LOCKS] = {};
+
+unsigned int _cs_depth = 0;
+uint32_t _cs_start = 0;
+uint32_t _cs_long_count = 0;
+uint32_t _cs_max_cycles = 0;
+const char* _cs_max_function = nullptr;
+
+inline
+uint32_t _Bit(uint8_t id)
+{
+    return uint32_t(1) << id;
+}
+
+void _AddEdge(uint8_t from, uint8_t to)
+{
+    _after[from] |= _Bit(to);
+    const uint32_t reach = _Bit(to) | _reach[to];
+    for(uint8_t id = 0; id < _count; ++id) {
+        if(id == from || (_reach[id] & _Bit(from)) != 0) {
+            _reach[id] |= reach;
+        }
+    }
+}
+
+bool _IsSchedulerStarted()
+{
+    return xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED;
+}
+
+}
+
+uint8_t LockOrder::Register(const char* name)
+{
+    if(name == nullptr) {
+        return NO_ID;
+    }
+    CriticalSection lock;
+    if(_count == MAX_LOCKS) {
+        return NO_ID;
+    }
+    _names[_count] = name;
+    return _count++;
+}
+
+void LockOrder::OnAcquire(uint8_t id)
+{
+    if(id == NO_ID || !_IsSchedulerStarted()) {
+        return;
+    }
+    const uint32_t held = HeldLocks::data();
+    uint8_t violated = NO_ID;
+    {
+        CriticalSection lock;
+        for(uint8_t held_id = 0; held_id < _count; ++held_id) {
+            if((held & _Bit(held_id)) == 0) {
+                continue;
+            }
+            if(held_id == id || (_reach[id] & _Bit(held_id)) != 0) {
+                // inverted edge isn't added, so graph stays acyclic and shows the first order
+                if((_reported[id] & _Bit(held_id)) == 0) {
+                    _reported[id] |= _Bit(held_id);
+                    violated = held_id;
+                }
+                continue;
+            }
+            if((_after[held_id] & _Bit(id)) == 0) {
+                _AddEdge(held_id, id);
+            }
+        }
+    }
+    HeldLocks::SetData(held | _Bit(id));
+    if(violated != NO_ID) {
+        _Report(violated, id);
+    }
+}
+
+void LockOrder::OnRelease(uint8_t id)
+{
+    if(id == NO_ID || !_IsSchedulerStarted()) {
+        return;
+    }
+    HeldLocks::SetData(HeldLocks::data() & ~_Bit(id));
+}
+
+void LockOrder::OnCriticalEnter()
+{
+    if(_cs_depth++ == 0) {
+        _cs_start = soc_get_ccount();
+    }
+}
+
+void LockOrder::OnCriticalExit(const char* function)
+{
+    if(--_cs_depth != 0) {
+        return;
+    }
+    const uint32_t cycles = soc_get_ccount() - _cs_start;
+    if(cycles > CRITICAL_SECTION_MAX_CYCLES) {
+        _cs_long_count += 1;
+    }
+    if(cycles > _cs_max_cycles) {
+        _cs_max_cycles = cycles;
+        _cs_max_function = function;
+    }
+}
+
+void LockOrder::Dump()
+{
+    for(uint8_t id = 0; id < _count; ++id) {
+        std::string after;
+        for(uint8_t next = 0; next < _count; ++next) {
+            if((_after[id] & _Bit(next)) != 0) {
+                if(!after.empty()) {
+                    after += ' ';
+                }
+                after += _Name(next);
+            }
+        }
+        INFO << "LOCK" << _Name(id) << "before:" << after;
+    }
+    INFO << "CRITICAL SECTION max cycles" << _cs_max_cycles
+         << "in" << (_cs_max_function == nullptr ? "?" : _cs_max_function)
+         << "too long" << _cs_long_count;
+}
+
+const char* LockOrder::_Name(uint8_t id)
+{
+    return _names[id] == nullptr ? "?" : _names[id];
+}
+
+void LockOrder::_Report(uint8_t held, uint8_t id)
+{
+    if(held == id) {
+        ERROR << "LOCK ORDER VIOLATION: recursive lock" << _Name(id);
+        return;
+    }
+    // restore existing path id -> ... -> held, acquiring id closes the cycle
+    std::string path = _Name(id);
+    uint8_t current = id;
+    while(current != held) {
+        uint8_t next = 0;
+        while(next < _count && ((_after[current] & _Bit(next)) == 0
+                                || (next != held && (_reach[next] & _Bit(held)) == 0))) {
+            ++next;
+        }
+        if(next == _count) {
+            break;
+        }
+        path += " -> ";
+        path += _Name(next);
+        current = next;
+    }
+    ERROR << "LOCK ORDER VIOLATION: acquire" << _Name(id) << "while holding" << _Name(held)
+          << "but existing order is" << path;
+}
+
+}
+
+#endif
@@ -137,15 +137,14 @@ void Mqtt::_ProcessConnect(int)
         DEBUG << "Subscribe" << subscription.first;
         ESPP_CHECK(esp_mqtt_client_subscribe(_client, subscription.first.c_str(), 0) != -1);
     }
-    _is_connected = true;
+    _is_connected.store(true);
     DEBUG << "Connection finished";
 }
 
 void Mqtt::_ProcessDisconnect()
 {
     INFO << "Mqtt disconnected";
-    Mutex::LockGuard lock(_mutex);
-    _is_connected = false;
+    _is_connected.store(false);
 }
 
 void Mqtt::Subscribe(MqttSubscription& subscription, const std::string& topic)
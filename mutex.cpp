@@ -0,0 +1,139 @@
+#include "espp/mutex.h"
+#include "espp/critical_section.h"
+
+#include <cstring>
+
+static_assert(espp::MutexProfile::HISTOGRAM_SIZE == 8, "Dump prints 8 buckets");
+
+namespace espp {
+
+namespace {
+
+// entries are copied to stack of caller
+const std::size_t DUMP_MAX_MUTEXES = 8;
+
+struct DumpEntry {
+    char name[MutexProfile::NAME_LENGTH];
+    char max_wait_owner[MutexProfile::NAME_LENGTH];
+    uint32_t acquired;
+    uint32_t contended;
+    std::array<uint32_t, MutexProfile::HISTOGRAM_SIZE> wait_histogram;
+    uint32_t max_wait;
+    uint32_t max_hold;
+};
+
+}
+
+MutexProfile::MutexProfile(const char* name):
+    _name(name)
+{
+    CriticalSection lock;
+    _next = _First();
+    _First() = this;
+}
+
+MutexProfile::~MutexProfile()
+{
+    CriticalSection lock;
+    for(MutexProfile** profile = &_First(); *profile != nullptr; profile = &(*profile)->_next) {
+        if(*profile == this) {
+            *profile = _next;
+            return;
+        }
+    }
+}
+
+void MutexProfile::OnLocked(uint32_t start, uint32_t now, bool contended, TaskHandle_t prev_owner)
+{
+    // executed under mutex, so only Dump can race with it
+    _owner = xTaskGetCurrentTaskHandle();
+    _lock_time = now;
+    _acquired += 1;
+    if(!contended) {
+        _wait_histogram[0] += 1;
+        return;
+    }
+    _contended += 1;
+
+    const uint32_t wait = now - start;
+    std::size_t bucket = 0;
+    for(uint32_t limit = 1024; bucket < HISTOGRAM_SIZE - 1 && wait >= limit; limit *= 4) {
+        bucket += 1;
+    }
+    _wait_histogram[bucket] += 1;
+
+    if(wait > _max_wait) {
+        _max_wait = wait;
+        const char* owner_name = prev_owner == nullptr ? "?" : pcTaskGetName(prev_owner);
+        std::strncpy(_max_wait_owner, owner_name, NAME_LENGTH - 1);
+    }
+}
+
+void MutexProfile::OnUnlock(uint32_t now)
+{
+    const uint32_t hold = now - _lock_time;
+    if(hold > _max_hold) {
+        _max_hold = hold;
+    }
+    _owner = nullptr;
+}
+
+void MutexProfile::Reset()
+{
+    _acquired = 0;
+    _contended = 0;
+    _wait_histogram = {};
+    _max_wait = 0;
+    _max_hold = 0;
+    _max_wait_owner[0] = 0;
+}
+
+void MutexProfile::Dump()
+{
+    // logging is slow, so copy statistic with suspended scheduler and log after it
+    std::array<DumpEntry, DUMP_MAX_MUTEXES> entries;
+    std::size_t count = 0;
+    std::size_t skipped = 0;
+    vTaskSuspendAll();
+    for(MutexProfile* profile = _First(); profile != nullptr; profile = profile->_next) {
+        if(count == entries.size()) {
+            skipped += 1;
+            continue;
+        }
+        DumpEntry& entry = entries[count++];
+        std::strncpy(entry.name, profile->name(), sizeof(entry.name) - 1);
+        entry.name[sizeof(entry.name) - 1] = 0;
+        std::memcpy(entry.max_wait_owner, profile->_max_wait_owner, sizeof(entry.max_wait_owner));
+        entry.acquired = profile->_acquired;
+        entry.contended = profile->_contended;
+        entry.wait_histogram = profile->_wait_histogram;
+        entry.max_wait = profile->_max_wait;
+        entry.max_hold = profile->_max_hold;
+    }
+    xTaskResumeAll();
+
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        const DumpEntry& entry = entries[idx];
+        const auto& histogram = entry.wait_histogram;
+        INFO << "MUTEX" << entry.name
+             << "acquired" << entry.acquired << "contended" << entry.contended
+             << "max wait" << entry.max_wait << "owner" << entry.max_wait_owner
+             << "max hold" << entry.max_hold
+             << "wait histogram" << histogram[0] << histogram[1] << histogram[2] << histogram[3]
+             << histogram[4] << histogram[5] << histogram[6] << histogram[7];
+    }
+    if(skipped != 0) {
+        INFO << "MUTEX" << skipped << "mutexes aren't reported";
+    }
+}
+
+void MutexProfile::ResetAll()
+{
+    vTaskSuspendAll();
+    for(MutexProfile* profile = _First(); profile != nullptr; profile = profile->_next) {
+        profile->Reset();
+    }
+    xTaskResumeAll();
+}
+
+}
@@ -0,0 +1,276 @@
+#include "espp/protobuf_delta.h"
+#include "espp/utils/macros.h"
+
+namespace espp {
+
+namespace {
+
+const uint32_t FNV_OFFSET = 2166136261u;
+const uint32_t FNV_PRIME = 16777619u;
+
+inline
+uint32_t _Hash(uint32_t hash, const void* data, std::size_t length)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(data);
+    for(const auto* end = bytes + length; bytes != end; ++bytes) {
+        hash = (hash ^ *bytes) * FNV_PRIME;
+    }
+    return hash;
+}
+
+/** protobuf-c sink which hashes packed nested message */
+struct HashSink: public ProtobufCBuffer {
+    uint32_t hash;
+
+    explicit
+    HashSink(uint32_t initial):
+        ProtobufCBuffer{_Append},
+        hash(initial)
+    {
+    }
+
+    static
+    void _Append(ProtobufCBuffer* buffer, std::size_t length, const uint8_t* data)
+    {
+        auto* sink = static_cast<HashSink*>(buffer);
+        sink->hash = _Hash(sink->hash, data, length);
+    }
+};
+
+template<class T>
+inline
+T& _Member(void* msg, unsigned int offset)
+{
+    return *reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(msg) + offset);
+}
+
+template<class T>
+inline
+const T& _Member(const void* msg, unsigned int offset)
+{
+    return *reinterpret_cast<const T*>(reinterpret_cast<const uint8_t*>(msg) + offset);
+}
+
+std::size_t _ScalarSize(ProtobufCType type)
+{
+    switch(type) {
+        case PROTOBUF_C_TYPE_INT64:
+        case PROTOBUF_C_TYPE_SINT64:
+        case PROTOBUF_C_TYPE_SFIXED64:
+        case PROTOBUF_C_TYPE_UINT64:
+        case PROTOBUF_C_TYPE_FIXED64:
+        case PROTOBUF_C_TYPE_DOUBLE:
+            return 8;
+        case PROTOBUF_C_TYPE_BOOL:
+            return sizeof(protobuf_c_boolean);
+        case PROTOBUF_C_TYPE_STRING:
+            return sizeof(char*);
+        case PROTOBUF_C_TYPE_BYTES:
+            return sizeof(ProtobufCBinaryData);
+        case PROTOBUF_C_TYPE_MESSAGE:
+            return sizeof(ProtobufCMessage*);
+        default:
+            return 4;
+    }
+}
+
+uint32_t _HashValue(uint32_t hash, ProtobufCType type, const void* value)
+{
+    switch(type) {
+        case PROTOBUF_C_TYPE_STRING: {
+            const char* str = *reinterpret_cast<const char* const*>(value);
+            return str == nullptr ? hash : _Hash(hash, str, std::strlen(str) + 1);
+        }
+        case PROTOBUF_C_TYPE_BYTES: {
+            const auto& bytes = *reinterpret_cast<const ProtobufCBinaryData*>(value);
+            hash = _Hash(hash, &bytes.len, sizeof(bytes.len));
+            return bytes.len == 0 ? hash : _Hash(hash, bytes.data, bytes.len);
+        }
+        case PROTOBUF_C_TYPE_MESSAGE: {
+            const auto* nested = *reinterpret_cast<const ProtobufCMessage* const*>(value);
+            if(nested == nullptr) {
+                return hash;
+            }
+            HashSink sink(hash);
+            protobuf_c_message_pack_to_buffer(nested, &sink);
+            return sink.hash;
+        }
+        default:
+            return _Hash(hash, value, _ScalarSize(type));
+    }
+}
+
+bool _IsZero(const void* value, std::size_t size)
+{
+    const auto* bytes = reinterpret_cast<const uint8_t*>(value);
+    for(const auto* end = bytes + size; bytes != end; ++bytes) {
+        if(*bytes != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/** Return false if field isn't present and can be omitted */
+bool _IsPresent(const ProtobufCMessage& msg, const ProtobufCFieldDescriptor& field)
+{
+    const void* value = &_Member<uint8_t>(&msg, field.offset);
+    if((field.flags & PROTOBUF_C_FIELD_FLAG_ONEOF) != 0) {
+        // quantifier is case enum shared by all members, it holds id of the set one
+        if(_Member<uint32_t>(&msg, field.quantifier_offset) != field.id) {
+            return false;
+        }
+        if(field.type == PROTOBUF_C_TYPE_STRING || field.type == PROTOBUF_C_TYPE_MESSAGE) {
+            return *reinterpret_cast<const void* const*>(value) != nullptr;
+        }
+        return true;
+    }
+    switch(field.label) {
+        case PROTOBUF_C_LABEL_REPEATED:
+            return _Member<std::size_t>(&msg, field.quantifier_offset) != 0;
+        case PROTOBUF_C_LABEL_OPTIONAL:
+            if(field.type == PROTOBUF_C_TYPE_STRING || field.type == PROTOBUF_C_TYPE_MESSAGE) {
+                return *reinterpret_cast<const void* const*>(value) != nullptr;
+            }
+            return _Member<protobuf_c_boolean>(&msg, field.quantifier_offset) != 0;
+        case PROTOBUF_C_LABEL_NONE:
+            if(field.type == PROTOBUF_C_TYPE_STRING) {
+                const char* str = *reinterpret_cast<const char* const*>(value);
+                return str != nullptr && *str != 0;
+            }
+            if(field.type == PROTOBUF_C_TYPE_BYTES) {
+                return reinterpret_cast<const ProtobufCBinaryData*>(value)->len != 0;
+            }
+            return !_IsZero(value, _ScalarSize(field.type));
+        default:
+            return true;
+    }
+}
+
+/** Hash of field value. 0 means field isn't present */
+uint32_t _HashField(const ProtobufCMessage& msg, const ProtobufCFieldDescriptor& field)
+{
+    if(!_IsPresent(msg, field)) {
+        return 0;
+    }
+    const void* value = &_Member<uint8_t>(&msg, field.offset);
+    uint32_t hash = FNV_OFFSET;
+    if(field.label == PROTOBUF_C_LABEL_REPEATED) {
+        const auto count = _Member<std::size_t>(&msg, field.quantifier_offset);
+        const auto* items = *reinterpret_cast<const uint8_t* const*>(value);
+        const auto item_size = _ScalarSize(field.type);
+        hash = _Hash(hash, &count, sizeof(count));
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            hash = _HashValue(hash, field.type, items + idx * item_size);
+        }
+    } else {
+        hash = _HashValue(hash, field.type, value);
+    }
+    return hash | 1u;
+}
+
+bool _IsAlwaysSent(const ProtobufCFieldDescriptor& field)
+{
+    return field.label == PROTOBUF_C_LABEL_REQUIRED || (field.flags & PROTOBUF_C_FIELD_FLAG_ONEOF) != 0;
+}
+
+/** Return why changed field can't be sent as delta or nullptr */
+const char* _KeyframeReason(const ProtobufCFieldDescriptor& field, uint32_t hash)
+{
+    if(hash == 0) {
+        return "was removed";
+    }
+    if(field.label == PROTOBUF_C_LABEL_REPEATED) {
+        return "is repeated and merge appends items";
+    }
+    if(field.type == PROTOBUF_C_TYPE_MESSAGE) {
+        return "is nested message and merge can't clear its fields";
+    }
+    return nullptr;
+}
+
+/** Clear field in shallow copy, so it isn't packed */
+void _Omit(ProtobufCMessage& delta, const ProtobufCFieldDescriptor& field)
+{
+    void* value = &_Member<uint8_t>(&delta, field.offset);
+    switch(field.label) {
+        case PROTOBUF_C_LABEL_REPEATED:
+            _Member<std::size_t>(&delta, field.quantifier_offset) = 0;
+            break;
+        case PROTOBUF_C_LABEL_OPTIONAL:
+            if(field.type == PROTOBUF_C_TYPE_STRING || field.type == PROTOBUF_C_TYPE_MESSAGE) {
+                *reinterpret_cast<void**>(value) = nullptr;
+            } else {
+                _Member<protobuf_c_boolean>(&delta, field.quantifier_offset) = 0;
+            }
+            break;
+        case PROTOBUF_C_LABEL_NONE:
+            std::memset(value, 0, _ScalarSize(field.type));
+            break;
+        default:;
+    }
+}
+
+}
+
+ProtoDelta::Kind ProtoDelta::Prepare(const ProtobufCMessage& msg, ProtobufCMessage& delta)
+{
+    const ProtobufCMessageDescriptor& descriptor = *msg.descriptor;
+    ESPP_CHECK(descriptor.n_fields <= _max_fields);
+    std::memcpy(&delta, &msg, descriptor.sizeof_message);
+    delta.n_unknown_fields = 0;
+
+    bool is_keyframe = !_has_keyframe || _since_keyframe + 1 >= _keyframe_interval;
+    bool is_changed = false;
+    for(unsigned int idx = 0; idx < descriptor.n_fields; ++idx) {
+        const ProtobufCFieldDescriptor& field = descriptor.fields[idx];
+        const uint32_t hash = _HashField(msg, field);
+        _pending[idx] = hash;
+        if(hash != _hashes[idx]) {
+            const char* reason = _KeyframeReason(field, hash);
+            if(reason != nullptr && !is_keyframe) {
+                VERBOSE << "Field" << field.name << reason << "and can't be sent as delta";
+                is_keyframe = true;
+            }
+            is_changed = true;
+        } else if(!_IsAlwaysSent(field)) {
+            _Omit(delta, field);
+        }
+    }
+    _pending_fields = descriptor.n_fields;
+
+    if(is_keyframe) {
+        std::memcpy(&delta, &msg, descriptor.sizeof_message);
+        _pending_kind = Kind::keyframe;
+        return Kind::keyframe;
+    }
+    if(!is_changed) {
+        _since_keyframe += 1;
+        _skipped += 1;
+        _pending_kind = Kind::unchanged;
+        return Kind::unchanged;
+    }
+    _pending_kind = Kind::delta;
+    return Kind::delta;
+}
+
+void ProtoDelta::Commit()
+{
+    switch(_pending_kind) {
+        case Kind::keyframe:
+            _has_keyframe = true;
+            _since_keyframe = 0;
+            _keyframes += 1;
+            break;
+        case Kind::delta:
+            _since_keyframe += 1;
+            _deltas += 1;
+            break;
+        case Kind::unchanged:
+            return;
+    }
+    std::memcpy(_hashes, _pending, _pending_fields * sizeof(uint32_t));
+    _pending_kind = Kind::unchanged;
+}
+
+}
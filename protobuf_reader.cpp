@@ -0,0 +1,154 @@
+#include "espp/protobuf_reader.h"
+
+#ifdef ENABLE_TEST
+#include <algorithm>
+
+#include "espp/protobuf.h"
+#include "espp/log.h"
+#include "espp/utils/low_level.h"
+#endif
+
+namespace espp {
+
+bool ProtoReader::_ReadVarint(uint64_t& value)
+{
+    value = 0;
+    for(unsigned int shift = 0; shift < 64; shift += 7) {
+        if(_current == _end) {
+            return false;
+        }
+        const uint8_t byte = *_current++;
+        value |= static_cast<uint64_t>(byte & 0x7Fu) << shift;
+        if((byte & 0x80u) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ProtoReader::Next()
+{
+    if(_current == _end) {
+        return false;
+    }
+    uint64_t tag;
+    if(!_ReadVarint(tag) || (tag >> 3u) == 0 || (tag >> 3u) > 0x1FFFFFFFu) {
+        return _Fail();
+    }
+    _field = static_cast<uint32_t>(tag >> 3u);
+    _wire_type = static_cast<ProtoWireType>(tag & 0x7u);
+    _value_data = _current;
+    switch(_wire_type) {
+        case ProtoWireType::varint:
+            if(!_ReadVarint(_value)) {
+                return _Fail();
+            }
+            break;
+        case ProtoWireType::fixed32: {
+            if(_end - _current < 4) {
+                return _Fail();
+            }
+            uint32_t value;
+            std::memcpy(&value, _current, sizeof(value));
+            _value = value;
+            _current += 4;
+            break;
+        }
+        case ProtoWireType::fixed64:
+            if(_end - _current < 8) {
+                return _Fail();
+            }
+            std::memcpy(&_value, _current, sizeof(_value));
+            _current += 8;
+            break;
+        case ProtoWireType::length_delimited:
+            if(!_ReadVarint(_value) || _value > static_cast<uint64_t>(_end - _current)) {
+                return _Fail();
+            }
+            _value_data = _current;
+            _current += _value;
+            break;
+        default:
+            // groups are deprecated and not supported
+            return _Fail();
+    }
+    _value_length = static_cast<std::size_t>(_current - _value_data);
+    return true;
+}
+
+bool ProtoReader::Find(uint32_t field)
+{
+    while(Next()) {
+        if(_field == field) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#ifdef ENABLE_TEST
+namespace testing {
+
+namespace {
+
+const unsigned int BENCHMARK_RUNS = 8;
+
+/** Visit all fields like application does and read their values */
+uint32_t __attribute__((noinline)) ReadAll(const Buffer& packed, unsigned int& fields)
+{
+    DECLARE_CYCLE_COUNT_VAR(start);
+    ProtoReader reader(packed);
+    uint64_t sum = 0;
+    fields = 0;
+    while(reader.Next()) {
+        fields += 1;
+        if(reader.wireType() == ProtoWireType::length_delimited) {
+            sum += reader.bytes().length();
+        } else {
+            sum += reader.varint();
+        }
+    }
+    DECLARE_CYCLE_COUNT_VAR(end);
+    if(reader.hasError()) {
+        fields = 0;
+    }
+    // keep sum alive
+    __asm__ __volatile__("" :: "r"(&sum) : "memory");
+    return end - start;
+}
+
+}
+
+ProtoReaderBenchmark testProtoReaderResult(const ProtobufCMessageDescriptor& descriptor, const Buffer& packed)
+{
+    ProtoReaderBenchmark result;
+    result.reader_cycles = UINT32_MAX;
+    result.unpack_cycles = UINT32_MAX;
+    result.arena_cycles = UINT32_MAX;
+    static StaticProtoArena<1024> arena;
+    for(unsigned int run = 0; run < BENCHMARK_RUNS; ++run) {
+        result.reader_cycles = std::min(result.reader_cycles, ReadAll(packed, result.fields));
+
+        DECLARE_CYCLE_COUNT_VAR(unpack_start);
+        auto* msg = protobuf_c_message_unpack(&descriptor, nullptr, packed.length(), packed.data());
+        if(msg != nullptr) {
+            protobuf_c_message_free_unpacked(msg, nullptr);
+        }
+        DECLARE_CYCLE_COUNT_VAR(unpack_end);
+        result.unpack_cycles = std::min(result.unpack_cycles, unpack_end - unpack_start);
+
+        arena.Reset();
+        DECLARE_CYCLE_COUNT_VAR(arena_start);
+        protobuf_c_message_unpack(&descriptor, arena.allocator(), packed.length(), packed.data());
+        DECLARE_CYCLE_COUNT_VAR(arena_end);
+        result.arena_cycles = std::min(result.arena_cycles, arena_end - arena_start);
+    }
+    INFO << "ProtoReader" << result.fields << "fields:" << result.reader_cycles << "cycles, unpack"
+         << result.unpack_cycles << "arena unpack" << result.arena_cycles;
+    return result;
+}
+
+}
+#endif
+
+}
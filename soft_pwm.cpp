@@ -0,0 +1,102 @@
+#include "espp/soft_pwm.h"
+#include "espp/critical_section.h"
+#include "espp/utils/macros.h"
+
+#include "driver/hw_timer.h"
+
+namespace espp {
+
+int SoftPwm::AddChannel(GpioPin& pin)
+{
+    if(_channels == MAX_CHANNELS) {
+        ERROR << "No free PWM channel for GPIO" << pin.pin();
+        return -1;
+    }
+    pin.EnableOutput();
+    pin.SetLowLevel();
+    CriticalSection lock;
+    _masks[_channels] = pin.mask();
+    return static_cast<int>(_channels++);
+}
+
+void SoftPwm::SetDuty(int channel, uint8_t duty)
+{
+    ESPP_ASSERT(channel >= 0 && static_cast<std::size_t>(channel) < _channels);
+    _duties[channel] = duty;
+    _on_times[channel] = _period_us * duty / MAX_DUTY;
+    _Commit();
+}
+
+void SoftPwm::_Commit()
+{
+    PwmSchedule schedule;
+    schedule.Build(_masks.data(), _on_times.data(), _channels, _period_us, MIN_STEP_US);
+    CriticalSection lock;
+    if(!_is_started) {
+        _schedules[_active] = schedule;
+        return;
+    }
+    // if previous update isn't applied yet, it's replaced
+    _schedules[_active ^ 1] = schedule;
+    _pending = true;
+}
+
+bool SoftPwm::Start()
+{
+    INFO << "Start software PWM with" << _channels << "channels, period" << _period_us << "us";
+    ESPP_ASSERT(!_is_started);
+    _Commit();
+    _step = _schedules[_active].size();
+    _is_started = true;
+    if(hw_timer_init(_Isr, this) != ESP_OK) {
+        ERROR << "Can't init hardware timer";
+        _is_started = false;
+        return false;
+    }
+    hw_timer_set_clkdiv(TIMER_CLKDIV_16);
+    hw_timer_set_intr_type(TIMER_EDGE_INT);
+    hw_timer_set_reload(false);
+    hw_timer_set_load_data(_period_us * TICKS_PER_US);
+    hw_timer_enable(true);
+    return true;
+}
+
+void SoftPwm::Stop()
+{
+    INFO << "Stop software PWM";
+    hw_timer_enable(false);
+    hw_timer_deinit();
+    _is_started = false;
+    uint32_t mask = 0;
+    for(std::size_t channel = 0; channel < _channels; ++channel) {
+        mask |= _masks[channel];
+    }
+    GPIO.out_w1tc = mask;
+}
+
+void IRAM_ATTR SoftPwm::_Isr(void* arg)
+{
+    SoftPwm& pwm = *reinterpret_cast<SoftPwm*>(arg);
+    uint32_t delay;
+    if(pwm._step >= pwm._schedules[pwm._active].size()) {
+        // period start
+        if(pwm._pending) {
+            pwm._active ^= 1;
+            pwm._pending = false;
+        }
+        const PwmSchedule& schedule = pwm._schedules[pwm._active];
+        GPIO.out_w1ts = schedule.high_mask();
+        GPIO.out_w1tc = schedule.low_mask();
+        pwm._step = 0;
+        pwm._periods += 1;
+        delay = schedule.first_delay();
+    } else {
+        const PwmSchedule& schedule = pwm._schedules[pwm._active];
+        GPIO.out_w1tc = schedule[pwm._step].mask;
+        delay = schedule.delay_after(pwm._step);
+        pwm._step += 1;
+    }
+    hw_timer_set_load_data(delay * TICKS_PER_US);
+}
+
+}
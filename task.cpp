@@ -0,0 +1,97 @@
+#include "espp/task.h"
+#include "espp/critical_section.h"
+
+#include <cstring>
+
+namespace espp {
+
+void Task::_Register()
+{
+    CriticalSection lock;
+    _next_task = _FirstTask();
+    _FirstTask() = this;
+}
+
+void Task::_Unregister()
+{
+    CriticalSection lock;
+    for(Task** task = &_FirstTask(); *task != nullptr; task = &(*task)->_next_task) {
+        if(*task == this) {
+            *task = _next_task;
+            _next_task = nullptr;
+            return;
+        }
+    }
+}
+
+void TaskStackMonitor::Sample()
+{
+    vTaskSuspendAll();
+    for(Task* task = _FirstTask(); task != nullptr; task = task->_next_task) {
+        if(task->_handle == nullptr) {
+            continue;
+        }
+        const UBaseType_t free_stack = uxTaskGetStackHighWaterMark(task->_handle);
+        if(!task->_is_stack_sampled || free_stack < task->_min_free_stack) {
+            task->_min_free_stack = free_stack;
+            task->_is_stack_sampled = true;
+        }
+    }
+    xTaskResumeAll();
+}
+
+namespace {
+
+const std::size_t REPORT_MAX_TASKS = 16;
+
+struct StackReport {
+    char name[configMAX_TASK_NAME_LEN];
+    configSTACK_DEPTH_TYPE depth;
+    UBaseType_t free;
+    configSTACK_DEPTH_TYPE recommended;
+};
+
+}
+
+void TaskStackMonitor::Report()
+{
+    // logging is slow, so copy report with suspended scheduler and log after it
+    std::array<StackReport, REPORT_MAX_TASKS> reports;
+    std::size_t count = 0;
+    std::size_t skipped = 0;
+    vTaskSuspendAll();
+    for(Task* task = _FirstTask(); task != nullptr; task = task->_next_task) {
+        if(!task->_is_stack_sampled) {
+            continue;
+        }
+        if(count == reports.size()) {
+            skipped += 1;
+            continue;
+        }
+        StackReport& report = reports[count++];
+        std::strncpy(report.name, task->name(), sizeof(report.name) - 1);
+        report.name[sizeof(report.name) - 1] = 0;
+        report.depth = task->stack_depth();
+        report.free = task->min_free_stack();
+        report.recommended = RecommendedDepth(*task);
+    }
+    xTaskResumeAll();
+
+    UBaseType_t total_depth = 0;
+    UBaseType_t total_recommended = 0;
+    for(std::size_t idx = 0; idx < count; ++idx) {
+        const StackReport& report = reports[idx];
+        INFO << "STACK" << report.name << "depth" << report.depth
+             << "used" << report.depth - report.free
+             << "free" << report.free << "recommended" << report.recommended;
+        total_depth += report.depth;
+        total_recommended += report.recommended;
+    }
+    if(skipped != 0) {
+        INFO << "STACK" << skipped << "tasks aren't reported";
+    }
+    INFO << "STACK total" << total_depth << "recommended" << total_recommended
+         << "static reserved" << static_reserved_memory();
+}
+
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+// Minimal checks for host tests
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace check {
+
+inline
+int& failures()
+{
+    static int count = 0;
+    return count;
+}
+
+/** Exit without destructors of static objects which detached task threads can still use */
+inline
+int Finish(const char* name)
+{
+    std::printf("%s: %s\n", name, failures() == 0 ? "OK" : "FAILED");
+    std::fflush(stdout);
+    std::_Exit(failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/** Time stamp counter of host CPU, 0 where it isn't available. It counts at nominal frequency */
+inline
+uint64_t Cycles()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_ia32_rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/**
+ * Nanoseconds per item of op called count times, where each call handles items of them.
+ * Host cycles per item are printed too
+ */
+template<class Op>
+double Benchmark(const char* name, unsigned int count, unsigned int items, const char* item, Op op)
+{
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t start_cycles = Cycles();
+    for(unsigned int idx = 0; idx < count; ++idx) {
+        op(idx);
+    }
+    const uint64_t cycles = Cycles() - start_cycles;
+    const auto end = std::chrono::steady_clock::now();
+    const double total = double(count) * items;
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count() / total;
+    if(cycles != 0) {
+        std::printf("BENCH %s: %.1f ns/%s, %.1f cycles/%s\n", name, ns, item, cycles / total, item);
+    } else {
+        std::printf("BENCH %s: %.1f ns/%s\n", name, ns, item);
+    }
+    return ns;
+}
+
+/** Nanoseconds per operation of op called count times */
+template<class Op>
+double Benchmark(const char* name, unsigned int count, Op op)
+{
+    return Benchmark(name, count, 1, "op", op);
+}
+}
+
+#define CHECK(x) do { \
+        if(!(x)) { \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #x); \
+            check::failures() += 1; \
+        } \
+    } while(0)
+
+#define CHECK_EQ(a, b) do { \
+        const auto _a = (a); \
+        const auto _b = (b); \
+        if(!(_a == _b)) { \
+            std::printf("%s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #a, #b, \
+                        static_cast<long long>(_a), static_cast<long long>(_b)); \
+            check::failures() += 1; \
+        } \
+    } while(0)
@@ -0,0 +1,6 @@
+#pragma once
+
+#include <cstdint>
+
+/** Cycles of 80 MHz CPU derived from monotonic clock */
+uint32_t soc_get_ccount();
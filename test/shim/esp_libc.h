@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstdio>
+
+inline int ets_putc(int c)
+{
+    return std::putchar(c);
+}
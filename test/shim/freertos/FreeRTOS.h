@@ -0,0 +1,39 @@
+#pragma once
+
+// Minimal FreeRTOS API on POSIX threads for host tests
+
+#include <cstddef>
+#include <cstdint>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t StackType_t;
+
+#define configTICK_RATE_HZ 100
+#define configMAX_TASK_NAME_LEN 16
+#define configNUM_THREAD_LOCAL_STORAGE_POINTERS 32
+#define configSUPPORT_STATIC_ALLOCATION 1
+#define configSTACK_DEPTH_TYPE uint16_t
+
+#define portMAX_DELAY 0xFFFFFFFFu
+#define portTICK_PERIOD_MS (1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms) (static_cast<TickType_t>((static_cast<uint64_t>(ms) * configTICK_RATE_HZ) / 1000))
+
+#define pdFALSE 0
+#define pdTRUE 1
+#define pdPASS 1
+#define pdFAIL 0
+
+#define IRAM_ATTR
+
+/** Critical sections and disabled interrupts are one global recursive lock */
+void vShimEnterCritical();
+void vShimExitCritical();
+
+#define portENTER_CRITICAL() vShimEnterCritical()
+#define portEXIT_CRITICAL() vShimExitCritical()
+#define portYIELD_FROM_ISR()
+
+inline void vPortETSIntrLock() { vShimEnterCritical(); }
+inline void vPortETSIntrUnlock() { vShimExitCritical(); }
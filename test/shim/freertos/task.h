@@ -0,0 +1,80 @@
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+struct ShimTask;
+typedef ShimTask* TaskHandle_t;
+typedef void (*TaskFunction_t)(void*);
+
+typedef struct {
+    TaskHandle_t xHandle;
+    const char* pcTaskName;
+    UBaseType_t xTaskNumber;
+} TaskStatus_t;
+
+typedef struct {
+    uint8_t dummy;
+} StaticTask_t;
+
+typedef enum {
+    eRunning,
+    eReady,
+    eBlocked,
+    eSuspended,
+    eDeleted,
+    eInvalid
+} eTaskState;
+
+typedef enum {
+    eNoAction,
+    eSetBits,
+    eIncrement,
+    eSetValueWithOverwrite,
+    eSetValueWithoutOverwrite
+} eNotifyAction;
+
+#define tskIDLE_PRIORITY 0
+#define taskSCHEDULER_NOT_STARTED 1
+#define taskSCHEDULER_RUNNING 2
+
+#define taskENTER_CRITICAL() vShimEnterCritical()
+#define taskEXIT_CRITICAL() vShimExitCritical()
+#define taskYIELD() vShimYield()
+
+void vShimYield();
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, configSTACK_DEPTH_TYPE stack_depth,
+                       void* param, UBaseType_t priority, TaskHandle_t* handle);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+                               UBaseType_t priority, StackType_t* stack, StaticTask_t* tcb);
+void vTaskDelete(TaskHandle_t handle);
+void vTaskDelay(TickType_t ticks);
+void vTaskDelayUntil(TickType_t* previous, TickType_t increment);
+TickType_t xTaskGetTickCount();
+TickType_t xTaskGetTickCountFromISR();
+BaseType_t xTaskGetSchedulerState();
+TaskHandle_t xTaskGetCurrentTaskHandle();
+char* pcTaskGetName(TaskHandle_t handle);
+void vTaskGetInfo(TaskHandle_t handle, TaskStatus_t* status, BaseType_t get_free_stack, eTaskState state);
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle);
+void vTaskSuspendAll();
+BaseType_t xTaskResumeAll();
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t index, void* value);
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t index);
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks);
+BaseType_t xTaskNotifyGive(TaskHandle_t handle);
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* woken);
+BaseType_t xTaskNotify(TaskHandle_t handle, uint32_t value, eNotifyAction action);
+BaseType_t xTaskNotifyFromISR(TaskHandle_t handle, uint32_t value, eNotifyAction action, BaseType_t* woken);
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks);
+
+/**
+ * Freeze tick count at value, so time dependent code can be stepped by test.
+ * Blocking calls still wait real time.
+ */
+void vShimSetTickCount(TickType_t ticks);
+
+/** Return to tick count of real time */
+void vShimReleaseTickCount();
@@ -0,0 +1,377 @@
+// Host implementation of the FreeRTOS API subset used by espp: tasks are std::threads,
+// critical sections share one recursive mutex and ticks follow steady_clock
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "esp8266/eagle_soc.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+struct ShimTask {
+    std::array<char, configMAX_TASK_NAME_LEN> name{};
+    UBaseType_t number = 0;
+    UBaseType_t stack_depth = 0;
+    std::array<void*, configNUM_THREAD_LOCAL_STORAGE_POINTERS> lts{};
+
+    std::mutex mutex;
+    std::condition_variable notified;
+    uint32_t value = 0;
+    bool is_pending = false;
+};
+
+struct ShimSemaphore {
+    std::mutex mutex;
+    std::condition_variable given;
+    UBaseType_t count = 0;
+    UBaseType_t max_count = 0;
+    TaskHandle_t holder = nullptr;
+    bool is_mutex = false;
+};
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+const Clock::time_point START = Clock::now();
+std::recursive_mutex critical;
+std::atomic<UBaseType_t> task_number{0};
+std::atomic<bool> is_tick_frozen{false};
+std::atomic<TickType_t> frozen_tick{0};
+
+thread_local TaskHandle_t current = nullptr;
+
+struct Start {
+    TaskFunction_t function;
+    void* param;
+    TaskHandle_t handle;
+};
+
+TaskHandle_t CreateTask(const char* name, UBaseType_t stack_depth)
+{
+    auto* task = new ShimTask;
+    std::strncpy(task->name.data(), name == nullptr ? "" : name, task->name.size() - 1);
+    task->number = ++task_number;
+    task->stack_depth = stack_depth;
+    return task;
+}
+
+TaskHandle_t Self()
+{
+    if(current == nullptr) {
+        current = CreateTask("main", 0);
+    }
+    return current;
+}
+
+TaskHandle_t Resolve(TaskHandle_t handle)
+{
+    return handle == nullptr ? Self() : handle;
+}
+
+/** Real time deadline of ticks from now. False if wait is infinite */
+bool Deadline(TickType_t ticks, Clock::time_point& deadline)
+{
+    if(ticks == portMAX_DELAY) {
+        return false;
+    }
+    deadline = Clock::now() + std::chrono::milliseconds(static_cast<uint64_t>(ticks) * portTICK_PERIOD_MS);
+    return true;
+}
+
+template<class Lock, class Predicate>
+bool WaitFor(std::condition_variable& cv, Lock& lock, TickType_t ticks, Predicate predicate)
+{
+    Clock::time_point deadline;
+    if(!Deadline(ticks, deadline)) {
+        cv.wait(lock, predicate);
+        return true;
+    }
+    return cv.wait_until(lock, deadline, predicate);
+}
+
+}
+
+void vShimEnterCritical()
+{
+    critical.lock();
+}
+
+void vShimExitCritical()
+{
+    critical.unlock();
+}
+
+void vShimYield()
+{
+    std::this_thread::yield();
+}
+
+void vShimSetTickCount(TickType_t ticks)
+{
+    frozen_tick.store(ticks);
+    is_tick_frozen.store(true);
+}
+
+void vShimReleaseTickCount()
+{
+    is_tick_frozen.store(false);
+}
+
+uint32_t soc_get_ccount()
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - START).count();
+    return static_cast<uint32_t>(ns * 80 / 1000);
+}
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char* name, configSTACK_DEPTH_TYPE stack_depth,
+                       void* param, UBaseType_t, TaskHandle_t* handle)
+{
+    const TaskHandle_t task = CreateTask(name, stack_depth);
+    if(handle != nullptr) {
+        *handle = task;
+    }
+    std::thread([function, param, task]() {
+        current = task;
+        function(param);
+    }).detach();
+    return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t function, const char* name, uint32_t stack_depth, void* param,
+                               UBaseType_t priority, StackType_t*, StaticTask_t*)
+{
+    TaskHandle_t handle = nullptr;
+    xTaskCreate(function, name, static_cast<configSTACK_DEPTH_TYPE>(stack_depth), param, priority, &handle);
+    return handle;
+}
+
+void vTaskDelete(TaskHandle_t)
+{
+    // thread ends when task function returns
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<uint64_t>(ticks) * portTICK_PERIOD_MS));
+}
+
+void vTaskDelayUntil(TickType_t* previous, TickType_t increment)
+{
+    *previous += increment;
+    const auto wait = static_cast<int32_t>(*previous - xTaskGetTickCount());
+    if(wait > 0) {
+        vTaskDelay(static_cast<TickType_t>(wait));
+    }
+}
+
+TickType_t xTaskGetTickCount()
+{
+    if(is_tick_frozen.load()) {
+        return frozen_tick.load();
+    }
+    const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - START).count();
+    return static_cast<TickType_t>(ms / portTICK_PERIOD_MS);
+}
+
+TickType_t xTaskGetTickCountFromISR()
+{
+    return xTaskGetTickCount();
+}
+
+BaseType_t xTaskGetSchedulerState()
+{
+    return taskSCHEDULER_RUNNING;
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return Self();
+}
+
+char* pcTaskGetName(TaskHandle_t handle)
+{
+    return Resolve(handle)->name.data();
+}
+
+void vTaskGetInfo(TaskHandle_t handle, TaskStatus_t* status, BaseType_t, eTaskState)
+{
+    const TaskHandle_t task = Resolve(handle);
+    status->xHandle = task;
+    status->pcTaskName = task->name.data();
+    status->xTaskNumber = task->number;
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t handle)
+{
+    // stack usage isn't measured on host
+    return Resolve(handle)->stack_depth;
+}
+
+void vTaskSuspendAll()
+{
+    critical.lock();
+}
+
+BaseType_t xTaskResumeAll()
+{
+    critical.unlock();
+    return pdFALSE;
+}
+
+void vTaskSetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t index, void* value)
+{
+    Resolve(handle)->lts.at(static_cast<std::size_t>(index)) = value;
+}
+
+void* pvTaskGetThreadLocalStoragePointer(TaskHandle_t handle, BaseType_t index)
+{
+    return Resolve(handle)->lts.at(static_cast<std::size_t>(index));
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    ShimTask& task = *Self();
+    std::unique_lock<std::mutex> lock(task.mutex);
+    WaitFor(task.notified, lock, ticks, [&task]() { return task.value != 0; });
+    const uint32_t result = task.value;
+    if(result != 0) {
+        task.value = clear_on_exit == pdTRUE ? 0 : result - 1;
+    }
+    task.is_pending = false;
+    return result;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t handle, uint32_t value, eNotifyAction action)
+{
+    ShimTask& task = *handle;
+    {
+        std::lock_guard<std::mutex> lock(task.mutex);
+        switch(action) {
+            case eSetBits:
+                task.value |= value;
+                break;
+            case eIncrement:
+                task.value += 1;
+                break;
+            case eSetValueWithOverwrite:
+                task.value = value;
+                break;
+            case eSetValueWithoutOverwrite:
+                if(task.is_pending) {
+                    return pdFAIL;
+                }
+                task.value = value;
+                break;
+            case eNoAction:
+                break;
+        }
+        task.is_pending = true;
+    }
+    task.notified.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t handle, uint32_t value, eNotifyAction action, BaseType_t* woken)
+{
+    if(woken != nullptr) {
+        *woken = pdFALSE;
+    }
+    return xTaskNotify(handle, value, action);
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t handle)
+{
+    return xTaskNotify(handle, 0, eIncrement);
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t handle, BaseType_t* woken)
+{
+    xTaskNotifyFromISR(handle, 0, eIncrement, woken);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit, uint32_t* value, TickType_t ticks)
+{
+    ShimTask& task = *Self();
+    std::unique_lock<std::mutex> lock(task.mutex);
+    if(!task.is_pending) {
+        task.value &= ~clear_on_entry;
+    }
+    const bool is_notified = WaitFor(task.notified, lock, ticks, [&task]() { return task.is_pending; });
+    if(value != nullptr) {
+        *value = task.value;
+    }
+    if(!is_notified) {
+        return pdFALSE;
+    }
+    task.value &= ~clear_on_exit;
+    task.is_pending = false;
+    return pdTRUE;
+}
+
+SemaphoreHandle_t xSemaphoreCreateCounting(UBaseType_t max_count, UBaseType_t initial_count)
+{
+    auto* semaphore = new ShimSemaphore;
+    semaphore->max_count = max_count;
+    semaphore->count = initial_count;
+    return semaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    auto* semaphore = xSemaphoreCreateCounting(1, 1);
+    semaphore->is_mutex = true;
+    return semaphore;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore)
+{
+    delete semaphore;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(semaphore->mutex);
+    if(!WaitFor(semaphore->given, lock, ticks, [semaphore]() { return semaphore->count != 0; })) {
+        return pdFALSE;
+    }
+    semaphore->count -= 1;
+    if(semaphore->is_mutex) {
+        semaphore->holder = Self();
+    }
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    {
+        std::lock_guard<std::mutex> lock(semaphore->mutex);
+        if(semaphore->count == semaphore->max_count) {
+            return pdFALSE;
+        }
+        semaphore->count += 1;
+        semaphore->holder = nullptr;
+    }
+    semaphore->given.notify_one();
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t semaphore, BaseType_t* woken)
+{
+    if(woken != nullptr) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(semaphore);
+}
+
+TaskHandle_t xSemaphoreGetMutexHolder(SemaphoreHandle_t semaphore)
+{
+    std::lock_guard<std::mutex> lock(semaphore->mutex);
+    return semaphore->holder;
+}
@@ -0,0 +1,94 @@
+// Host test and benchmark of 8x8 bit transpose
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_bit_transpose.cpp
+
+#include "espp/drivers/bit_transpose.h"
+
+#include <random>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+/** Bit (7 - col) of in[row] goes to bit (7 - row) of out[col] */
+void ReferenceTranspose(const uint8_t in[8], uint8_t out[8])
+{
+    for(unsigned int col = 0; col < 8; ++col) {
+        uint8_t value = 0;
+        for(unsigned int row = 0; row < 8; ++row) {
+            const unsigned int bit = (in[row] >> (7 - col)) & 1;
+            value |= static_cast<uint8_t>(bit << (7 - row));
+        }
+        out[col] = value;
+    }
+}
+
+void TestTransposeAgainstReference()
+{
+    std::mt19937 random(7);
+    uint8_t in[8];
+    uint8_t out[8];
+    uint8_t expected[8];
+    unsigned int mismatches = 0;
+    for(unsigned int round = 0; round < 100000; ++round) {
+        for(auto& value: in) {
+            value = static_cast<uint8_t>(random());
+        }
+        espp::Transpose8x8(in, out);
+        ReferenceTranspose(in, expected);
+        for(unsigned int idx = 0; idx < 8; ++idx) {
+            mismatches += out[idx] != expected[idx] ? 1 : 0;
+        }
+        // transpose is its own inverse
+        uint8_t back[8];
+        espp::Transpose8x8(out, back);
+        for(unsigned int idx = 0; idx < 8; ++idx) {
+            mismatches += back[idx] != in[idx] ? 1 : 0;
+        }
+    }
+    CHECK_EQ(mismatches, 0u);
+
+    // single bits
+    for(unsigned int row = 0; row < 8; ++row) {
+        for(unsigned int col = 0; col < 8; ++col) {
+            uint8_t single[8] = {};
+            single[row] = static_cast<uint8_t>(0x80 >> col);
+            espp::Transpose8x8(single, out);
+            for(unsigned int idx = 0; idx < 8; ++idx) {
+                CHECK_EQ(out[idx], idx == col ? 0x80 >> row : 0);
+            }
+        }
+    }
+}
+
+void Benchmark()
+{
+    const unsigned int count = 1 << 20;
+    std::vector<uint8_t> data(count);
+    std::mt19937 random(8);
+    for(auto& value: data) {
+        value = static_cast<uint8_t>(random());
+    }
+    std::vector<uint8_t> planes(count);
+    const double transpose = check::Benchmark("Transpose8x8", count / 8, [&](unsigned int idx) {
+        espp::Transpose8x8(&data[8 * idx], &planes[8 * idx]);
+    });
+    const double reference = check::Benchmark("ReferenceTranspose", count / 8, [&](unsigned int idx) {
+        ReferenceTranspose(&data[8 * idx], &planes[8 * idx]);
+    });
+    uint32_t sum = 0;
+    for(auto plane: planes) {
+        sum += plane;
+    }
+    std::printf("BENCH Transpose8x8 speedup %.1fx (checksum %u)\n", reference / transpose, sum);
+}
+
+}
+
+int main()
+{
+    TestTransposeAgainstReference();
+    Benchmark();
+    return check::Finish("test_bit_transpose");
+}
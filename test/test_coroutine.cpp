@@ -0,0 +1,168 @@
+// Host test of CoroutineScheduler on FreeRTOS shim
+//
+//      g++ -std=gnu++11 -pthread -I include -I test/shim -I test test/test_coroutine.cpp test/shim/shim.cpp coroutine.cpp log.cpp task.cpp
+
+#include "espp/coroutine.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+class Await: public espp::Coroutine {
+public:
+    bool is_ready = false;
+    unsigned int resumed = 0;
+
+    State Resume() override
+    {
+        resumed += 1;
+        CO_BEGIN();
+        CO_AWAIT(is_ready);
+        CO_END();
+    }
+};
+
+class Delay: public espp::Coroutine {
+public:
+    unsigned int resumed = 0;
+
+    State Resume() override
+    {
+        resumed += 1;
+        CO_BEGIN();
+        CO_DELAY_MS(100);
+        CO_END();
+    }
+};
+
+class Event: public espp::Coroutine {
+public:
+    bool is_done = false;
+
+    State Resume() override
+    {
+        CO_BEGIN();
+        CO_AWAIT_EVENT(0x2);
+        is_done = true;
+        CO_END();
+    }
+};
+
+class Yield: public espp::Coroutine {
+public:
+    std::atomic<unsigned int>* done = nullptr;
+
+    State Resume() override
+    {
+        CO_BEGIN();
+        CO_YIELD();
+        *done += 1;
+        CO_END();
+    }
+};
+
+void TestAwait()
+{
+    espp::CoroutineScheduler scheduler("await", 1, 2048, 50);
+    Await await;
+    scheduler.Add(await);
+    CHECK_EQ(scheduler.Step(0), pdMS_TO_TICKS(50));
+    CHECK_EQ(scheduler.Step(0), pdMS_TO_TICKS(50));
+    await.is_ready = true;
+    CHECK_EQ(scheduler.Step(0), portMAX_DELAY);
+    CHECK_EQ(await.resumed, 3u);
+    // done coroutine is removed
+    CHECK_EQ(scheduler.Step(0), portMAX_DELAY);
+    CHECK_EQ(await.resumed, 3u);
+}
+
+void TestDelay()
+{
+    espp::CoroutineScheduler scheduler("delay");
+    Delay delay;
+    vShimSetTickCount(1000);
+    scheduler.Add(delay);
+    CHECK_EQ(scheduler.Step(0), pdMS_TO_TICKS(100));
+    vShimSetTickCount(1000 + pdMS_TO_TICKS(100) / 2);
+    CHECK_EQ(scheduler.Step(0), pdMS_TO_TICKS(100) - pdMS_TO_TICKS(100) / 2);
+    CHECK_EQ(delay.resumed, 1u);
+    vShimSetTickCount(1000 + pdMS_TO_TICKS(100));
+    CHECK_EQ(scheduler.Step(0), portMAX_DELAY);
+    CHECK_EQ(delay.resumed, 2u);
+    vShimReleaseTickCount();
+}
+
+void TestEvent()
+{
+    espp::CoroutineScheduler scheduler("event");
+    Event event;
+    scheduler.Add(event);
+    scheduler.Step(0x1);
+    CHECK(!event.is_done);
+    scheduler.Step(0x2);
+    CHECK(event.is_done);
+}
+
+void TestReady()
+{
+    espp::CoroutineScheduler scheduler("ready");
+    std::atomic<unsigned int> done{0};
+    Yield first;
+    Yield second;
+    first.done = &done;
+    second.done = &done;
+    scheduler.Add(first);
+    scheduler.Add(second);
+    CHECK_EQ(scheduler.Step(0), 0u);
+    CHECK_EQ(scheduler.Step(0), portMAX_DELAY);
+    CHECK_EQ(done.load(), 2u);
+}
+
+void TestConcurrentAdd()
+{
+    // scheduler is static: its task thread isn't stopped
+    static espp::CoroutineScheduler scheduler("concurrent");
+    static std::atomic<unsigned int> done{0};
+    const unsigned int threads = 4;
+    const unsigned int per_thread = 2000;
+    static std::vector<Yield> coroutines(threads * per_thread);
+    for(auto& coroutine: coroutines) {
+        coroutine.done = &done;
+    }
+    CHECK(espp::Task::Start(scheduler));
+
+    std::vector<std::thread> adders;
+    for(unsigned int thread = 0; thread < threads; ++thread) {
+        adders.emplace_back([thread, per_thread]() {
+            for(unsigned int idx = 0; idx < per_thread; ++idx) {
+                scheduler.Add(coroutines[thread * per_thread + idx]);
+                if(idx % 64 == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for(auto& adder: adders) {
+        adder.join();
+    }
+    for(unsigned int waited = 0; waited < 2000 && done.load() != coroutines.size(); ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK_EQ(done.load(), coroutines.size());
+}
+
+}
+
+int main()
+{
+    TestAwait();
+    TestDelay();
+    TestEvent();
+    TestReady();
+    TestConcurrentAdd();
+    return check::Finish("test_coroutine");
+}
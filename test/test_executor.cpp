@@ -0,0 +1,151 @@
+// Host test of Executor on FreeRTOS shim
+//
+//      g++ -std=gnu++11 -pthread -I include -I test/shim -I test test/test_executor.cpp test/shim/shim.cpp log.cpp task.cpp
+
+#include "espp/executor.h"
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+struct Record {
+    int value;
+    TickType_t tick;
+};
+
+std::mutex records_mutex;
+std::vector<Record> records;
+
+void Add(int value)
+{
+    std::lock_guard<std::mutex> lock(records_mutex);
+    records.push_back({value, xTaskGetTickCount()});
+}
+
+std::vector<Record> Take()
+{
+    std::lock_guard<std::mutex> lock(records_mutex);
+    std::vector<Record> result;
+    result.swap(records);
+    return result;
+}
+
+template<class Executor>
+bool WaitExecuted(const Executor& executor, unsigned int count, unsigned int timeout_ms = 2000)
+{
+    for(unsigned int waited = 0; waited < timeout_ms; ++waited) {
+        if(executor.stats().executed >= count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+void TestPriorityOrder()
+{
+    // executors are static: worker threads aren't stopped
+    static espp::Executor<16> executor("priority");
+    const int priorities[] = {0, 2, 1, 2, 0, 1};
+    for(int idx = 0; idx < 6; ++idx) {
+        CHECK(executor.Post([idx]() { Add(idx); }, priorities[idx]));
+    }
+    CHECK_EQ(executor.stats().depth, 6u);
+    CHECK(executor.Start());
+    CHECK(WaitExecuted(executor, 6));
+    const auto result = Take();
+    // higher priority first, post order inside priority
+    const int expected[] = {1, 3, 2, 5, 0, 4};
+    CHECK_EQ(result.size(), 6u);
+    for(std::size_t idx = 0; idx < result.size() && idx < 6; ++idx) {
+        CHECK_EQ(result[idx].value, expected[idx]);
+    }
+}
+
+void TestDelayedOrder()
+{
+    static espp::Executor<16> executor("delayed");
+    CHECK(executor.Start());
+    const TickType_t start = xTaskGetTickCount();
+    CHECK(executor.PostDelayed([]() { Add(300); }, 300));
+    CHECK(executor.PostDelayed([]() { Add(100); }, 100));
+    CHECK(executor.PostDelayed([]() { Add(200); }, 200));
+    CHECK(executor.Post([]() { Add(0); }));
+    CHECK(WaitExecuted(executor, 4));
+    const auto result = Take();
+    const int expected[] = {0, 100, 200, 300};
+    CHECK_EQ(result.size(), 4u);
+    for(std::size_t idx = 0; idx < result.size() && idx < 4; ++idx) {
+        CHECK_EQ(result[idx].value, expected[idx]);
+        CHECK(result[idx].tick - start >= pdMS_TO_TICKS(expected[idx]));
+    }
+}
+
+void TestDelayedBecomesReadyByPriority()
+{
+    static espp::Executor<16> executor("mixed");
+    // both delayed jobs are due when worker starts, so priority decides
+    CHECK(executor.PostDelayed([]() { Add(1); }, 10, 0));
+    CHECK(executor.PostDelayed([]() { Add(2); }, 20, 5));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    CHECK(executor.Start());
+    CHECK(WaitExecuted(executor, 2));
+    const auto result = Take();
+    CHECK_EQ(result.size(), 2u);
+    if(result.size() == 2) {
+        CHECK_EQ(result[0].value, 2);
+        CHECK_EQ(result[1].value, 1);
+    }
+}
+
+void TestCapacity()
+{
+    static espp::Executor<4> executor("capacity");
+    for(int idx = 0; idx < 4; ++idx) {
+        CHECK(executor.Post([]() {}));
+    }
+    CHECK(!executor.Post([]() {}));
+    CHECK(!executor.PostFromISR([]() {}));
+    const auto stats = executor.stats();
+    CHECK_EQ(stats.dropped, 2u);
+    CHECK_EQ(stats.depth, 4u);
+    CHECK_EQ(stats.max_depth, 4u);
+    CHECK(executor.Start());
+    CHECK(WaitExecuted(executor, 4));
+    CHECK(executor.Post([]() {}));
+}
+
+void BenchmarkLatency()
+{
+    static espp::Executor<64> executor("bench");
+    CHECK(executor.Start());
+    const unsigned int count = 20000;
+    unsigned int posted = 0;
+    check::Benchmark("Executor::Post", count, [&posted](unsigned int) {
+        while(!executor.Post([]() {})) {
+            std::this_thread::yield();
+        }
+        posted += 1;
+    });
+    CHECK(WaitExecuted(executor, posted));
+    const auto stats = executor.stats();
+    // shim ccount runs at 80 MHz
+    std::printf("BENCH Executor latency: avg %.1f us, max %.1f us, max depth %u\n",
+                stats.avg_latency_cycles() / 80.0, stats.max_latency_cycles / 80.0, stats.max_depth);
+}
+
+}
+
+int main()
+{
+    TestPriorityOrder();
+    TestDelayedOrder();
+    TestDelayedBecomesReadyByPriority();
+    TestCapacity();
+    BenchmarkLatency();
+    return check::Finish("test_executor");
+}
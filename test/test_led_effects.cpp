@@ -0,0 +1,205 @@
+// Host test and benchmark of fixed-point LED effects
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_led_effects.cpp
+
+#include "espp/drivers/led_effects.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using espp::LedColor;
+namespace led = espp::led;
+
+bool Equal(const LedColor& a, uint8_t red, uint8_t green, uint8_t blue)
+{
+    return a.red == red && a.green == green && a.blue == blue;
+}
+
+bool Equal(const LedColor& a, const LedColor& b)
+{
+    return Equal(a, b.red, b.green, b.blue);
+}
+
+void TestHsv()
+{
+    // region starts are primary and secondary colors
+    CHECK(Equal(led::Hsv(0, 0xFF, 0xFF), 0xFF, 0, 0));
+    CHECK(Equal(led::Hsv(43, 0xFF, 0xFF), 0xFF, 0xFF, 0));
+    CHECK(Equal(led::Hsv(86, 0xFF, 0xFF), 0, 0xFF, 0));
+    CHECK(Equal(led::Hsv(129, 0xFF, 0xFF), 0, 0xFF, 0xFF));
+    CHECK(Equal(led::Hsv(172, 0xFF, 0xFF), 0, 0, 0xFF));
+    CHECK(Equal(led::Hsv(215, 0xFF, 0xFF), 0xFF, 0, 0xFF));
+
+    // no saturation is gray of value for any hue
+    for(unsigned int hue = 0; hue < 256; ++hue) {
+        CHECK(Equal(led::Hsv(static_cast<uint8_t>(hue), 0, 0x5A), 0x5A, 0x5A, 0x5A));
+        CHECK(Equal(led::Hsv(static_cast<uint8_t>(hue), 0xFF, 0), 0, 0, 0));
+    }
+
+    // neighbour hues differ by small step, including across region boundaries and 255 -> 0
+    int max_step = 0;
+    for(unsigned int hue = 0; hue < 256; ++hue) {
+        const LedColor a = led::Hsv(static_cast<uint8_t>(hue), 0xFF, 0xFF);
+        const LedColor b = led::Hsv(static_cast<uint8_t>(hue + 1), 0xFF, 0xFF);
+        max_step = std::max(max_step, std::abs(a.red - b.red));
+        max_step = std::max(max_step, std::abs(a.green - b.green));
+        max_step = std::max(max_step, std::abs(a.blue - b.blue));
+    }
+    CHECK(max_step <= 16);
+}
+
+void TestLerpAndBlend()
+{
+    const LedColor a(0x12, 0xFF, 0x00);
+    const LedColor b(0xEE, 0x00, 0x80);
+    CHECK(Equal(led::Lerp(a, b, 0), a));
+    CHECK(Equal(led::Lerp(a, b, 0xFF), b));
+    const LedColor middle = led::Lerp(a, b, 0x80);
+    CHECK(Equal(middle, 0x80, 0x7E, 0x40));
+
+    LedColor colors[2] = {a, b};
+    const LedColor other[2] = {b, a};
+    led::Blend(colors, other, 2, 0);
+    CHECK(Equal(colors[0], a) && Equal(colors[1], b));
+    led::Blend(colors, other, 2, 0xFF);
+    CHECK(Equal(colors[0], b) && Equal(colors[1], a));
+
+    led::Scale(colors, 2, 0xFF);
+    CHECK(Equal(colors[0], b));
+    led::Scale(colors, 2, 0);
+    CHECK(Equal(colors[0], 0, 0, 0) && Equal(colors[1], 0, 0, 0));
+}
+
+void TestGradient()
+{
+    const LedColor first(0x00, 0xFF, 0x10);
+    const LedColor last(0xFF, 0x00, 0x10);
+    LedColor colors[300];
+
+    led::Gradient(colors, 1, first, last);
+    CHECK(Equal(colors[0], first));
+
+    led::Gradient(colors, 2, first, last);
+    CHECK(Equal(colors[0], first));
+    CHECK(Equal(colors[1], last));
+
+    // red ascends and green descends monotonically to exact endpoints
+    for(std::size_t count: {3, 7, 256, 300}) {
+        led::Gradient(colors, count, first, last);
+        CHECK(Equal(colors[0], first));
+        CHECK(Equal(colors[count - 1], last));
+        unsigned int broken = 0;
+        for(std::size_t idx = 1; idx < count; ++idx) {
+            broken += colors[idx].red < colors[idx - 1].red ? 1 : 0;
+            broken += colors[idx].green > colors[idx - 1].green ? 1 : 0;
+            broken += colors[idx].blue != 0x10 ? 1 : 0;
+        }
+        CHECK_EQ(broken, 0u);
+    }
+}
+
+void TestPalette()
+{
+    std::array<LedColor, 16> entries;
+    for(std::size_t idx = 0; idx < entries.size(); ++idx) {
+        entries[idx] = LedColor(static_cast<uint8_t>(idx * 16), 0, static_cast<uint8_t>(0xFF - idx * 16));
+    }
+    const led::Palette16 palette(entries);
+    for(std::size_t idx = 0; idx < entries.size(); ++idx) {
+        CHECK(Equal(palette.At(static_cast<uint8_t>(idx << 4)), entries[idx]));
+    }
+    // last entry interpolates back to the first one
+    CHECK(Equal(palette.At(0xF8), led::Lerp(entries[15], entries[0], 0x80)));
+    CHECK(Equal(palette.At(0xFF), led::Lerp(entries[15], entries[0], 0xF0)));
+    CHECK(palette.At(0xFF).red < entries[15].red);
+
+    LedColor colors[4];
+    led::FillPalette(colors, 4, palette, 0xF0, 0x0800);
+    CHECK(Equal(colors[0], entries[15]));
+    CHECK(Equal(colors[2], entries[0]));
+}
+
+void TestFrameScheduler()
+{
+    led::FrameScheduler scheduler(10, 4);
+    scheduler.Start(1000);
+    CHECK_EQ(scheduler.Poll(999), 0u);
+    CHECK_EQ(scheduler.Poll(1000), 1u);
+    CHECK_EQ(scheduler.Poll(1005), 0u);
+    CHECK_EQ(scheduler.wait(1005), 5u);
+    CHECK_EQ(scheduler.Poll(1010), 1u);
+    // late by 3 frames, all are caught up without drift
+    CHECK_EQ(scheduler.Poll(1049), 3u);
+    CHECK_EQ(scheduler.wait(1049), 1u);
+    CHECK_EQ(scheduler.frame(), 5u);
+    CHECK_EQ(scheduler.dropped(), 0u);
+
+    // late by 10 frames, 4 are reported and 6 dropped, next frame is still on grid
+    CHECK_EQ(scheduler.Poll(1145), 4u);
+    CHECK_EQ(scheduler.dropped(), 6u);
+    CHECK_EQ(scheduler.frame(), 9u);
+    CHECK_EQ(scheduler.wait(1145), 5u);
+    CHECK_EQ(scheduler.Poll(1150), 1u);
+    CHECK_EQ(scheduler.frame() + scheduler.dropped(), 16u);
+
+    // time wraps around
+    scheduler.Start(0xFFFFFFF8);
+    CHECK_EQ(scheduler.Poll(0xFFFFFFF8), 1u);
+    CHECK_EQ(scheduler.Poll(0xFFFFFFFF), 0u);
+    CHECK_EQ(scheduler.wait(0xFFFFFFFF), 3u);
+    CHECK_EQ(scheduler.Poll(2), 1u);
+    CHECK_EQ(scheduler.Poll(25), 2u);
+    CHECK_EQ(scheduler.dropped(), 0u);
+}
+
+void Benchmark()
+{
+    const unsigned int length = 300;
+    const unsigned int count = 20000;
+    std::vector<LedColor> colors(length);
+    std::vector<LedColor> other(length);
+    uint32_t sum = 0;
+
+    check::Benchmark("Rainbow", count, length, "pixel", [&](unsigned int idx) {
+        led::Rainbow(colors.data(), length, static_cast<uint8_t>(idx), 0x0880);
+        sum += colors[idx % length].red;
+    });
+    check::Benchmark("Gradient", count, length, "pixel", [&](unsigned int idx) {
+        led::Gradient(other.data(), length, LedColor(static_cast<uint8_t>(idx), 0, 0xFF), LedColor(0, 0xFF, 0));
+        sum += other[idx % length].green;
+    });
+    std::array<LedColor, 16> entries;
+    led::Rainbow(entries.data(), entries.size(), 0, 0x1000);
+    const led::Palette16 palette(entries);
+    check::Benchmark("FillPalette", count, length, "pixel", [&](unsigned int idx) {
+        led::FillPalette(colors.data(), length, palette, static_cast<uint8_t>(idx), 0x0300);
+        sum += colors[idx % length].blue;
+    });
+    check::Benchmark("Blend", count, length, "pixel", [&](unsigned int idx) {
+        led::Blend(colors.data(), other.data(), length, static_cast<uint8_t>(idx));
+        sum += colors[idx % length].red;
+    });
+    check::Benchmark("Scale", count, length, "pixel", [&](unsigned int idx) {
+        led::Scale(colors.data(), length, 0xF0);
+        sum += colors[idx % length].red;
+    });
+    std::printf("BENCH checksum %u\n", sum);
+}
+
+}
+
+int main()
+{
+    TestHsv();
+    TestLerpAndBlend();
+    TestGradient();
+    TestPalette();
+    TestFrameScheduler();
+    Benchmark();
+    return check::Finish("test_led_effects");
+}
@@ -0,0 +1,97 @@
+// Host test and benchmark of WS2812 I2S encoder
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_led_encoding.cpp
+
+#include "espp/drivers/ws2812_encoder.h"
+
+#include <random>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using espp::Ws2812I2sEncoder;
+
+/** I2S line levels in send order: high half word first, MSB first */
+std::vector<int> Waveform(uint32_t word)
+{
+    std::vector<int> levels;
+    for(int bit = 31; bit >= 0; --bit) {
+        levels.push_back((word >> bit) & 1);
+    }
+    return levels;
+}
+
+void TestEncoderGolden()
+{
+    CHECK_EQ(Ws2812I2sEncoder::Encode(0x00), 0x88888888u);
+    CHECK_EQ(Ws2812I2sEncoder::Encode(0xFF), 0xEEEEEEEEu);
+    CHECK_EQ(Ws2812I2sEncoder::Encode(0xA5), 0xE8E88E8Eu);
+    CHECK_EQ(Ws2812I2sEncoder::Encode(0x80), 0xE8888888u);
+    CHECK_EQ(Ws2812I2sEncoder::Encode(0x01), 0x8888888Eu);
+
+    const uint8_t data[] = {0x12, 0x34, 0xC3};
+    uint32_t words[3];
+    Ws2812I2sEncoder::Encode(data, 3, words);
+    CHECK_EQ(words[0], 0x888E88E8u);
+    CHECK_EQ(words[1], 0x88EE8E88u);
+    CHECK_EQ(words[2], 0xEE8888EEu);
+}
+
+/** Every data bit is 1.25 us with high time in WS2812 T0H / T1H windows */
+void TestEncoderWaveform()
+{
+    // one I2S bit at 32 bits per sample and SAMPLE_RATE samples
+    const double bit_ns = 1e9 / (Ws2812I2sEncoder::SAMPLE_RATE * 32.0);
+    CHECK_EQ(static_cast<int>(bit_ns * 10), 3125);
+    for(unsigned int value = 0; value < 256; ++value) {
+        const auto levels = Waveform(Ws2812I2sEncoder::Encode(static_cast<uint8_t>(value)));
+        for(unsigned int data_bit = 0; data_bit < 8; ++data_bit) {
+            const int* symbol = &levels[4 * data_bit];
+            // high then low, starting with high
+            unsigned int high = 0;
+            while(high < 4 && symbol[high] == 1) {
+                high += 1;
+            }
+            for(unsigned int idx = high; idx < 4; ++idx) {
+                CHECK_EQ(symbol[idx], 0);
+            }
+            const double high_ns = high * bit_ns;
+            if(((value >> (7 - data_bit)) & 1) != 0) {
+                CHECK(high_ns >= 580 && high_ns <= 1000);
+            } else {
+                CHECK(high_ns >= 220 && high_ns <= 380);
+            }
+        }
+    }
+}
+
+void Benchmark()
+{
+    const unsigned int count = 1 << 20;
+    std::vector<uint8_t> data(count);
+    std::mt19937 random(8);
+    for(auto& value: data) {
+        value = static_cast<uint8_t>(random());
+    }
+    std::vector<uint32_t> words(count);
+    check::Benchmark("Ws2812I2sEncoder::Encode per 64 bytes", count / 64, [&](unsigned int idx) {
+        Ws2812I2sEncoder::Encode(&data[64 * idx], 64, &words[64 * idx]);
+    });
+    uint32_t sum = 0;
+    for(auto word: words) {
+        sum += word;
+    }
+    std::printf("BENCH checksum %u\n", sum);
+}
+
+}
+
+int main()
+{
+    TestEncoderGolden();
+    TestEncoderWaveform();
+    Benchmark();
+    return check::Finish("test_led_encoding");
+}
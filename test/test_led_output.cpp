@@ -0,0 +1,124 @@
+// Host test and benchmark of LED output stage
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_led_output.cpp
+
+#include "espp/drivers/led_output.h"
+
+#include <cmath>
+#include <random>
+
+#include "check.h"
+
+namespace {
+
+using Stage = espp::LedOutputStage<300>;
+
+const uint8_t* Output(Stage& stage, const uint8_t* colors)
+{
+    return reinterpret_cast<const uint8_t*>(stage.Apply(colors));
+}
+
+void TestBrightnessZero()
+{
+    uint8_t colors[Stage::CHANNELS];
+    for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+        colors[idx] = static_cast<uint8_t>(idx);
+    }
+    for(bool dithering: {false, true}) {
+        Stage stage(220, 0, dithering);
+        unsigned int lit = 0;
+        for(unsigned int frame = 0; frame < 100; ++frame) {
+            const uint8_t* out = Output(stage, colors);
+            for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+                lit += out[idx] != 0 ? 1 : 0;
+            }
+        }
+        CHECK_EQ(lit, 0u);
+    }
+}
+
+/** Linear gamma and full brightness keep colors as is, dithering has nothing to add */
+void TestIdentity()
+{
+    uint8_t colors[Stage::CHANNELS];
+    for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+        colors[idx] = static_cast<uint8_t>(idx * 7);
+    }
+    for(bool dithering: {false, true}) {
+        Stage stage(100, 0xFF, dithering);
+        unsigned int mismatches = 0;
+        for(unsigned int frame = 0; frame < 10; ++frame) {
+            const uint8_t* out = Output(stage, colors);
+            for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+                mismatches += out[idx] != colors[idx] ? 1 : 0;
+            }
+        }
+        CHECK_EQ(mismatches, 0u);
+    }
+}
+
+/** Average of dithered 8 bit output over frames is the 8.8 intensity within 1/frames */
+void TestDitheringConverges()
+{
+    const unsigned int frames = 256;
+    const uint8_t brightness[] = {0x10, 0x80, 0xC3, 0xFF};
+    for(uint8_t level: brightness) {
+        Stage stage(220, level, true);
+        uint8_t colors[Stage::CHANNELS];
+        for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+            colors[idx] = static_cast<uint8_t>(idx);
+        }
+        uint32_t sums[Stage::CHANNELS] = {};
+        for(unsigned int frame = 0; frame < frames; ++frame) {
+            const uint8_t* out = Output(stage, colors);
+            for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+                sums[idx] += out[idx];
+            }
+        }
+        const uint32_t scale = uint32_t(level) + (level >> 7);
+        unsigned int far = 0;
+        for(std::size_t idx = 0; idx < Stage::CHANNELS; ++idx) {
+            const uint32_t lut = static_cast<uint32_t>(std::pow(colors[idx] / 255.0, 2.2) * 0xFF00 + 0.5);
+            const double target = (lut * scale) >> 8;
+            const double average = sums[idx] * 256.0 / frames;
+            far += std::fabs(average - target) > 256.0 / frames ? 1 : 0;
+        }
+        CHECK_EQ(far, 0u);
+    }
+
+    // without dithering the same low level is lost to truncation
+    Stage plain(220, 0x10, false);
+    uint8_t dim[Stage::CHANNELS] = {};
+    dim[0] = 40;
+    CHECK_EQ(Output(plain, dim)[0], 0);
+}
+
+void Benchmark()
+{
+    std::mt19937 random(9);
+    uint8_t colors[Stage::CHANNELS];
+    for(auto& color: colors) {
+        color = static_cast<uint8_t>(random());
+    }
+    uint32_t sum = 0;
+    for(bool dithering: {false, true}) {
+        Stage stage(220, 0xC0, dithering);
+        check::Benchmark(dithering ? "LedOutputStage::Apply dithered" : "LedOutputStage::Apply",
+                         20000, Stage::CHANNELS / 3, "pixel", [&](unsigned int idx) {
+            colors[idx % Stage::CHANNELS] += 1;
+            sum += Output(stage, colors)[idx % Stage::CHANNELS];
+        });
+    }
+    std::printf("BENCH checksum %u\n", sum);
+}
+
+}
+
+int main()
+{
+    TestBrightnessZero();
+    TestIdentity();
+    TestDitheringConverges();
+    Benchmark();
+    return check::Finish("test_led_output");
+}
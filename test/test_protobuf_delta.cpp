@@ -0,0 +1,420 @@
+// Host test of ProtoDelta change detection and keyframe bookkeeping and of ProtoDeltaState merge.
+// Needs only protobuf-c headers, packer of nested messages is replaced by test double
+//
+//      g++ -std=gnu++11 -pthread -I include -I test/shim -I test test/test_protobuf_delta.cpp test/shim/shim.cpp protobuf_delta.cpp protobuf_reader.cpp log.cpp task.cpp
+//
+// Messages are laid out as protoc-c generates them for this file:
+//
+//      syntax = "proto2";
+//      message Inner { optional int32 a = 1; }
+//      message State {
+//        required bool on = 1; optional uint32 brightness = 2; optional string name = 3;
+//        repeated uint32 colors = 4; optional Inner inner = 5;
+//        oneof mode { uint32 effect = 6; string scene = 7; }
+//      }
+
+#include "espp/protobuf_delta.h"
+#include "espp/protobuf_reader.h"
+
+#include <array>
+#include <cstddef>
+#include <vector>
+
+#include "check.h"
+
+/** Test double of protobuf-c packer, it's called only to hash nested message. Raw fields are enough for that */
+size_t protobuf_c_message_pack_to_buffer(const ProtobufCMessage* message, ProtobufCBuffer* buffer)
+{
+    const std::size_t length = message->descriptor->sizeof_message - sizeof(ProtobufCMessage);
+    buffer->append(buffer, length, reinterpret_cast<const uint8_t*>(message) + sizeof(ProtobufCMessage));
+    return length;
+}
+
+namespace {
+
+using Kind = espp::ProtoDelta::Kind;
+
+struct Inner {
+    ProtobufCMessage base;
+    protobuf_c_boolean has_a;
+    int32_t a;
+};
+
+enum StateModeCase {
+    STATE__MODE__NOT_SET = 0,
+    STATE__MODE_EFFECT = 6,
+    STATE__MODE_SCENE = 7,
+};
+
+struct State {
+    ProtobufCMessage base;
+    protobuf_c_boolean on;
+    protobuf_c_boolean has_brightness;
+    uint32_t brightness;
+    char* name;
+    size_t n_colors;
+    uint32_t* colors;
+    Inner* inner;
+    StateModeCase mode_case;
+    union {
+        uint32_t effect;
+        char* scene;
+    };
+};
+
+ProtobufCFieldDescriptor Field(const char* name, uint32_t id, ProtobufCLabel label, ProtobufCType type,
+                               unsigned int quantifier_offset, unsigned int offset, uint32_t flags = 0)
+{
+    ProtobufCFieldDescriptor field = {};
+    field.name = name;
+    field.id = id;
+    field.label = label;
+    field.type = type;
+    field.quantifier_offset = quantifier_offset;
+    field.offset = offset;
+    field.flags = flags;
+    return field;
+}
+
+const ProtobufCFieldDescriptor INNER_FIELDS[] = {
+    Field("a", 1, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_INT32, offsetof(Inner, has_a), offsetof(Inner, a)),
+};
+
+const ProtobufCFieldDescriptor STATE_FIELDS[] = {
+    Field("on", 1, PROTOBUF_C_LABEL_REQUIRED, PROTOBUF_C_TYPE_BOOL, 0, offsetof(State, on)),
+    Field("brightness", 2, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_UINT32,
+          offsetof(State, has_brightness), offsetof(State, brightness)),
+    Field("name", 3, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_STRING, 0, offsetof(State, name)),
+    Field("colors", 4, PROTOBUF_C_LABEL_REPEATED, PROTOBUF_C_TYPE_UINT32,
+          offsetof(State, n_colors), offsetof(State, colors)),
+    Field("inner", 5, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_MESSAGE, 0, offsetof(State, inner)),
+    Field("effect", 6, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_UINT32,
+          offsetof(State, mode_case), offsetof(State, effect), PROTOBUF_C_FIELD_FLAG_ONEOF),
+    Field("scene", 7, PROTOBUF_C_LABEL_OPTIONAL, PROTOBUF_C_TYPE_STRING,
+          offsetof(State, mode_case), offsetof(State, scene), PROTOBUF_C_FIELD_FLAG_ONEOF),
+};
+
+ProtobufCMessageDescriptor Descriptor(const char* name, std::size_t size, const ProtobufCFieldDescriptor* fields,
+                                      unsigned int n_fields)
+{
+    ProtobufCMessageDescriptor descriptor = {};
+    descriptor.name = name;
+    descriptor.sizeof_message = size;
+    descriptor.n_fields = n_fields;
+    descriptor.fields = fields;
+    return descriptor;
+}
+
+const ProtobufCMessageDescriptor INNER_DESCRIPTOR = Descriptor("Inner", sizeof(Inner), INNER_FIELDS, 1);
+const ProtobufCMessageDescriptor STATE_DESCRIPTOR = Descriptor("State", sizeof(State), STATE_FIELDS, 7);
+
+const std::size_t MAX_FIELDS = 8;
+
+/** ProtoDelta with its hash memory, prepared message goes to delta */
+struct Delta {
+    std::array<uint32_t, MAX_FIELDS> hashes = {};
+    std::array<uint32_t, MAX_FIELDS> pending = {};
+    espp::ProtoDelta delta;
+    State prepared;
+
+    explicit
+    Delta(unsigned int keyframe_interval = 100):
+        delta(hashes.data(), pending.data(), MAX_FIELDS, keyframe_interval)
+    {
+    }
+
+    Kind Prepare(const State& msg)
+    {
+        return delta.Prepare(msg.base, prepared.base);
+    }
+
+    Kind Send(const State& msg)
+    {
+        const Kind kind = Prepare(msg);
+        delta.Commit();
+        return kind;
+    }
+};
+
+/** State with every field set */
+struct FullState {
+    char name[8] = "lamp";
+    uint32_t colors[3] = {0xFF0000, 0x00FF00, 0x0000FF};
+    Inner inner = {};
+    State msg = {};
+
+    FullState()
+    {
+        inner.base.descriptor = &INNER_DESCRIPTOR;
+        inner.has_a = true;
+        inner.a = 3;
+        msg.base.descriptor = &STATE_DESCRIPTOR;
+        msg.on = true;
+        msg.has_brightness = true;
+        msg.brightness = 200;
+        msg.name = name;
+        msg.n_colors = 3;
+        msg.colors = colors;
+        msg.inner = &inner;
+        msg.mode_case = STATE__MODE_EFFECT;
+        msg.effect = 2;
+    }
+
+    FullState(const FullState&) = delete;
+};
+
+void TestChangedFieldsOnly()
+{
+    FullState state;
+    Delta delta;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    CHECK(std::memcmp(&delta.prepared, &state.msg, sizeof(State)) == 0);
+    CHECK(delta.Send(state.msg) == Kind::unchanged);
+
+    state.msg.brightness = 100;
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    const State& prepared = delta.prepared;
+    CHECK(prepared.has_brightness);
+    CHECK_EQ(prepared.brightness, 100u);
+    CHECK(prepared.name == nullptr);
+    CHECK_EQ(prepared.n_colors, 0u);
+    CHECK(prepared.inner == nullptr);
+    // required and oneof fields are always sent
+    CHECK(prepared.on);
+    CHECK_EQ(prepared.mode_case, STATE__MODE_EFFECT);
+    CHECK_EQ(prepared.effect, 2u);
+
+    // same length, other content
+    state.name[0] = 'L';
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    CHECK(delta.prepared.name == state.name);
+    CHECK(!delta.prepared.has_brightness);
+
+    // value 0 which is set differs from missing value
+    state.msg.brightness = 0;
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    CHECK(delta.Send(state.msg) == Kind::unchanged);
+
+    CHECK_EQ(delta.delta.keyframes(), 1u);
+    CHECK_EQ(delta.delta.deltas(), 3u);
+    CHECK_EQ(delta.delta.skipped(), 2u);
+}
+
+/** Without Commit the same change is prepared again */
+void TestFailedPublishIsRepeated()
+{
+    FullState state;
+    Delta delta;
+    CHECK(delta.Prepare(state.msg) == Kind::keyframe);
+    CHECK(delta.Prepare(state.msg) == Kind::keyframe);
+    delta.delta.Commit();
+
+    state.msg.brightness = 1;
+    CHECK(delta.Prepare(state.msg) == Kind::delta);
+    CHECK(delta.Prepare(state.msg) == Kind::delta);
+    delta.delta.Commit();
+    CHECK(delta.Prepare(state.msg) == Kind::unchanged);
+    CHECK_EQ(delta.delta.keyframes(), 1u);
+    CHECK_EQ(delta.delta.deltas(), 1u);
+}
+
+/** Keyframe is sent every interval messages, unchanged ones are counted too */
+void TestKeyframeCadence()
+{
+    FullState state;
+    Delta delta(4);
+    std::vector<Kind> kinds;
+    for(unsigned int idx = 0; idx < 9; ++idx) {
+        state.msg.brightness = idx;
+        kinds.push_back(delta.Send(state.msg));
+    }
+    const std::vector<Kind> expected = {
+        Kind::keyframe, Kind::delta, Kind::delta, Kind::delta,
+        Kind::keyframe, Kind::delta, Kind::delta, Kind::delta,
+        Kind::keyframe,
+    };
+    CHECK(kinds == expected);
+
+    kinds.clear();
+    for(unsigned int idx = 0; idx < 4; ++idx) {
+        kinds.push_back(delta.Send(state.msg));
+    }
+    const std::vector<Kind> unchanged = {Kind::unchanged, Kind::unchanged, Kind::unchanged, Kind::keyframe};
+    CHECK(kinds == unchanged);
+
+    delta.delta.ForceKeyframe();
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    CHECK_EQ(delta.delta.keyframes(), 5u);
+}
+
+/** Changes which protobuf merge can't apply to receiver state */
+void TestKeyframeIsForced()
+{
+    FullState state;
+    Delta delta;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+
+    state.msg.has_brightness = false;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    state.msg.name = nullptr;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    state.colors[1] = 0;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    state.msg.n_colors = 2;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    state.inner.a = 4;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    CHECK(delta.prepared.inner == &state.inner);
+
+    // oneof value is changed in place, then other member is set
+    state.msg.effect = 5;
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    char scene[] = "night";
+    state.msg.mode_case = STATE__MODE_SCENE;
+    state.msg.scene = scene;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    CHECK(delta.Send(state.msg) == Kind::unchanged);
+
+    // set fields are sent as delta
+    state.msg.has_brightness = true;
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    CHECK(delta.prepared.has_brightness);
+    CHECK(delta.prepared.n_colors == 0);
+}
+
+/** Oneof presence is read from case field, value 0 is present */
+void TestOneofCase()
+{
+    FullState state;
+    state.msg.mode_case = STATE__MODE__NOT_SET;
+    state.msg.effect = 0;
+    Delta delta;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+    state.msg.mode_case = STATE__MODE_EFFECT;
+    CHECK(delta.Send(state.msg) == Kind::delta);
+    CHECK_EQ(delta.prepared.mode_case, STATE__MODE_EFFECT);
+    CHECK(delta.Send(state.msg) == Kind::unchanged);
+    state.msg.mode_case = STATE__MODE__NOT_SET;
+    CHECK(delta.Send(state.msg) == Kind::keyframe);
+
+    // unset scene shares union with effect and is null
+    state.msg.mode_case = STATE__MODE_SCENE;
+    CHECK(delta.Send(state.msg) == Kind::unchanged);
+}
+
+/** Message of varint fields which are merged as protobuf: last value wins. 0 means missing */
+struct VarintsMsg {
+    std::array<uint64_t, 8> values = {};
+
+    bool Unpack(const espp::Buffer& buffer, espp::ProtoArena& /*arena*/)
+    {
+        values = {};
+        espp::ProtoReader reader(buffer);
+        while(reader.Next()) {
+            if(reader.field() < values.size() && reader.wireType() == espp::ProtoWireType::varint) {
+                values[reader.field()] = reader.varint();
+            }
+        }
+        return !reader.hasError();
+    }
+
+    template<std::size_t size>
+    bool PackTo(espp::StaticBuffer<size>& buffer) const
+    {
+        const std::vector<uint8_t> packed = Pack(values);
+        if(packed.size() > size) {
+            buffer.Clear();
+            return false;
+        }
+        std::memcpy(buffer.writeData(), packed.data(), packed.size());
+        buffer.Resize(packed.size());
+        return true;
+    }
+
+    static
+    std::vector<uint8_t> Pack(const std::array<uint64_t, 8>& values)
+    {
+        std::vector<uint8_t> packed;
+        for(std::size_t field = 1; field < values.size(); ++field) {
+            if(values[field] == 0) {
+                continue;
+            }
+            packed.push_back(static_cast<uint8_t>(field << 3));
+            uint64_t value = values[field];
+            for(; value >= 0x80; value >>= 7) {
+                packed.push_back(static_cast<uint8_t>(value | 0x80));
+            }
+            packed.push_back(static_cast<uint8_t>(value));
+        }
+        return packed;
+    }
+};
+
+/** Apply packed fields to state */
+template<class DeltaState, class Apply>
+bool ApplyFields(DeltaState& state, const std::array<uint64_t, 8>& values, Apply apply)
+{
+    const std::vector<uint8_t> packed = VarintsMsg::Pack(values);
+    const uint8_t empty = 0;
+    const espp::Buffer buffer(packed.empty() ? &empty : packed.data(), packed.size());
+    return (state.*apply)(buffer);
+}
+
+void TestStateMerge()
+{
+    // keyframe and delta fit, but many deltas only because state is packed back after merge
+    espp::ProtoDeltaState<VarintsMsg, 16, 64> state;
+    using DeltaState = decltype(state);
+    CHECK(!ApplyFields(state, {0, 0, 7}, &DeltaState::ApplyDelta));
+    CHECK(!state.hasKeyframe());
+
+    CHECK(ApplyFields(state, {0, 5, 7, 0, 300}, &DeltaState::ApplyKeyframe));
+    CHECK(state.hasKeyframe());
+    for(uint64_t value = 1; value <= 20; ++value) {
+        CHECK(ApplyFields(state, {0, 0, value * 1000}, &DeltaState::ApplyDelta));
+    }
+    const std::array<uint64_t, 8> expected = {0, 5, 20000, 0, 300};
+    CHECK(state.message().values == expected);
+
+    // keyframe replaces state
+    CHECK(ApplyFields(state, {0, 0, 0, 9}, &DeltaState::ApplyKeyframe));
+    const std::array<uint64_t, 8> replaced = {0, 0, 0, 9};
+    CHECK(state.message().values == replaced);
+
+    // delta which doesn't fit drops state until next keyframe
+    CHECK(!ApplyFields(state, {0, 1ull << 50, 1ull << 50}, &DeltaState::ApplyDelta));
+    CHECK(!state.hasKeyframe());
+    CHECK(!ApplyFields(state, {0, 1}, &DeltaState::ApplyDelta));
+    CHECK(ApplyFields(state, {0, 1}, &DeltaState::ApplyKeyframe));
+
+    // malformed delta
+    const uint8_t broken[] = {0x08, 0x80};
+    CHECK(!state.ApplyDelta(espp::Buffer(broken, sizeof(broken))));
+    CHECK(!state.hasKeyframe());
+}
+
+void Benchmark()
+{
+    FullState state;
+    Delta delta(1000);
+    unsigned int deltas = 0;
+    check::Benchmark("ProtoDelta::Prepare of 7 fields", 1 << 18, [&](unsigned int idx) {
+        state.msg.brightness = idx & 1;
+        deltas += delta.Send(state.msg) == Kind::delta ? 1 : 0;
+    });
+    std::printf("BENCH checksum %u\n", deltas);
+}
+
+}
+
+int main()
+{
+    TestChangedFieldsOnly();
+    TestFailedPublishIsRepeated();
+    TestKeyframeCadence();
+    TestKeyframeIsForced();
+    TestOneofCase();
+    TestStateMerge();
+    Benchmark();
+    return check::Finish("test_protobuf_delta");
+}
@@ -0,0 +1,425 @@
+// Host test and benchmark of compile-time protobuf encoders. Needs only protobuf-c headers
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_protobuf_encoder.cpp
+//
+// Messages are laid out as protoc-c generates them for these files:
+//
+//      syntax = "proto2";
+//      enum Color { NEGATIVE = -1; ZERO = 0; ONE = 1; }
+//      message Inner { optional sint32 a = 1; optional string s = 2; }
+//      message Scalars {
+//        required int32 i32 = 1;   optional sint32 s32 = 2;  optional sint64 s64 = 3;
+//        optional Color color = 4; optional double d = 5;    optional uint64 u64 = 6;
+//        optional fixed32 f32 = 7; optional bool flag = 8;   required string name = 9;
+//        optional Inner inner = 10; optional bytes data = 11;
+//        repeated int32 unpacked = 12; repeated sint32 packed = 13 [packed = true];
+//        repeated Inner items = 14;
+//      }
+//
+//      syntax = "proto3";
+//      message Implicit { int32 i32 = 1; double d = 2; string s = 3; repeated uint32 packed = 4; float f = 5; }
+//
+// Golden bytes are wire output of the same messages, e.g.
+//
+//      echo 'i32: 0 name: ""' | protoc --encode=Scalars scalars.proto | xxd -i
+
+#include "espp/protobuf_encoder.h"
+
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+enum Color {
+    COLOR__NEGATIVE = -1,
+    COLOR__ZERO = 0,
+    COLOR__ONE = 1,
+};
+
+struct Inner {
+    ProtobufCMessage base;
+    protobuf_c_boolean has_a;
+    int32_t a;
+    char* s;
+};
+
+struct Scalars {
+    ProtobufCMessage base;
+    int32_t i32;
+    protobuf_c_boolean has_s32;
+    int32_t s32;
+    protobuf_c_boolean has_s64;
+    int64_t s64;
+    protobuf_c_boolean has_color;
+    Color color;
+    protobuf_c_boolean has_d;
+    double d;
+    protobuf_c_boolean has_u64;
+    uint64_t u64;
+    protobuf_c_boolean has_f32;
+    uint32_t f32;
+    protobuf_c_boolean has_flag;
+    protobuf_c_boolean flag;
+    char* name;
+    Inner* inner;
+    protobuf_c_boolean has_data;
+    ProtobufCBinaryData data;
+    size_t n_unpacked;
+    int32_t* unpacked;
+    size_t n_packed;
+    int32_t* packed;
+    size_t n_items;
+    Inner** items;
+};
+
+struct Implicit {
+    ProtobufCMessage base;
+    int32_t i32;
+    double d;
+    char* s;
+    size_t n_packed;
+    uint32_t* packed;
+    float f;
+};
+
+using InnerEncoder = espp::proto::Encoder<
+    PROTO_FIELD_OPTIONAL(1, SInt32, Inner, a),
+    PROTO_FIELD_OPTIONAL_PTR(2, String, Inner, s)
+>;
+
+using InnerPtrEncoder = espp::proto::Message<InnerEncoder>;
+
+using ScalarsEncoder = espp::proto::Encoder<
+    PROTO_FIELD_REQUIRED(1, Int32, Scalars, i32),
+    PROTO_FIELD_OPTIONAL(2, SInt32, Scalars, s32),
+    PROTO_FIELD_OPTIONAL(3, SInt64, Scalars, s64),
+    PROTO_FIELD_OPTIONAL(4, Enum, Scalars, color),
+    PROTO_FIELD_OPTIONAL(5, Double, Scalars, d),
+    PROTO_FIELD_OPTIONAL(6, UInt64, Scalars, u64),
+    PROTO_FIELD_OPTIONAL(7, Fixed32, Scalars, f32),
+    PROTO_FIELD_OPTIONAL(8, Bool, Scalars, flag),
+    PROTO_FIELD_REQUIRED(9, String, Scalars, name),
+    espp::proto::OptionalPtr<10, InnerPtrEncoder, Scalars, Inner*, &Scalars::inner>,
+    PROTO_FIELD_OPTIONAL(11, Bytes, Scalars, data),
+    PROTO_FIELD_REPEATED(12, Int32, Scalars, unpacked),
+    PROTO_FIELD_PACKED(13, SInt32, Scalars, packed),
+    espp::proto::Repeated<14, InnerPtrEncoder, Scalars, Inner*, &Scalars::items, &Scalars::n_items>
+>;
+
+using ImplicitEncoder = espp::proto::Encoder<
+    PROTO_FIELD(1, Int32, Implicit, i32),
+    PROTO_FIELD(2, Double, Implicit, d),
+    PROTO_FIELD(3, String, Implicit, s),
+    PROTO_FIELD_PACKED(4, UInt32, Implicit, packed),
+    PROTO_FIELD(5, Float, Implicit, f)
+>;
+
+struct VectorSink: public ProtobufCBuffer {
+    std::vector<uint8_t> data;
+
+    VectorSink()
+    {
+        append = _Append;
+    }
+
+    static
+    void _Append(ProtobufCBuffer* buffer, std::size_t length, const uint8_t* data)
+    {
+        auto* sink = static_cast<VectorSink*>(buffer);
+        sink->data.insert(sink->data.end(), data, data + length);
+    }
+};
+
+/** Size, PackTo into buffer and PackTo into sink all give golden bytes */
+template<class Enc, class T>
+void CheckGolden(const T& msg, const std::vector<uint8_t>& golden)
+{
+    CHECK_EQ(Enc::Size(msg), golden.size());
+
+    std::vector<uint8_t> packed(golden.size() + 1, 0xAA);
+    CHECK_EQ(Enc::PackTo(msg, packed.data(), golden.size()), golden.size());
+    CHECK(std::vector<uint8_t>(packed.begin(), packed.begin() + golden.size()) == golden);
+    // nothing is written past packed size
+    CHECK_EQ(packed.back(), 0xAA);
+
+    VectorSink sink;
+    CHECK_EQ(Enc::PackTo(msg, &sink), golden.size());
+    CHECK(sink.data == golden);
+
+    if(!golden.empty()) {
+        CHECK_EQ(Enc::PackTo(msg, packed.data(), golden.size() - 1), 0u);
+    }
+}
+
+/** Required fields only, name is null like in message after init */
+void TestRequiredOnly()
+{
+    Scalars msg = {};
+    CheckGolden<ScalarsEncoder>(msg, {0x08, 0x00, 0x4a, 0x00});
+}
+
+/** Negative int32 and enum take 10 bytes, zigzag, -0.0, unpacked and packed repeated, nested */
+void TestNegativeAndRepeated()
+{
+    Inner first = {};
+    first.has_a = true;
+    first.a = -3;
+    Inner second = {};
+    Inner* items[] = {&first, &second};
+    int32_t unpacked[] = {-2, 300};
+    int32_t packed[] = {0, -1, 1, -64, 64};
+    char empty[] = "";
+
+    Scalars msg = {};
+    msg.i32 = -1;
+    msg.has_s32 = true;
+    msg.s32 = -1;
+    msg.has_s64 = true;
+    msg.s64 = std::numeric_limits<int64_t>::min();
+    msg.has_color = true;
+    msg.color = COLOR__NEGATIVE;
+    msg.has_d = true;
+    msg.d = -0.0;
+    msg.name = empty;
+    msg.n_unpacked = 2;
+    msg.unpacked = unpacked;
+    msg.n_packed = 5;
+    msg.packed = packed;
+    msg.n_items = 2;
+    msg.items = items;
+
+    CheckGolden<ScalarsEncoder>(msg, {
+        0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x10, 0x01,
+        0x18, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x20, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+        0x4a, 0x00,
+        0x60, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x60, 0xac, 0x02,
+        0x6a, 0x06, 0x00, 0x01, 0x02, 0x7f, 0x80, 0x01,
+        0x72, 0x02, 0x08, 0x05,
+        0x72, 0x00,
+    });
+}
+
+/** NaN double, max values, nested message with string, bytes with zero byte */
+void TestNanAndNested()
+{
+    char hi[] = "hi";
+    Inner inner = {};
+    inner.has_a = true;
+    inner.a = std::numeric_limits<int32_t>::min();
+    inner.s = hi;
+    uint8_t data[] = {0x01, 0x00, 0xFF};
+    char name[] = "lamp";
+
+    Scalars msg = {};
+    msg.i32 = 150;
+    msg.has_s32 = true;
+    msg.s32 = std::numeric_limits<int32_t>::max();
+    msg.has_color = true;
+    msg.color = COLOR__ONE;
+    msg.has_d = true;
+    msg.d = std::numeric_limits<double>::quiet_NaN();
+    msg.has_u64 = true;
+    msg.u64 = std::numeric_limits<uint64_t>::max();
+    msg.has_f32 = true;
+    msg.f32 = 0xFFFFFFFF;
+    msg.has_flag = true;
+    msg.flag = 2;
+    msg.name = name;
+    msg.inner = &inner;
+    msg.has_data = true;
+    msg.data.len = sizeof(data);
+    msg.data.data = data;
+
+    CheckGolden<ScalarsEncoder>(msg, {
+        0x08, 0x96, 0x01,
+        0x10, 0xfe, 0xff, 0xff, 0xff, 0x0f,
+        0x20, 0x01,
+        0x29, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf8, 0x7f,
+        0x30, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x3d, 0xff, 0xff, 0xff, 0xff,
+        0x40, 0x01,
+        0x4a, 0x04, 0x6c, 0x61, 0x6d, 0x70,
+        0x52, 0x0a, 0x08, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x12, 0x02, 0x68, 0x69,
+        0x5a, 0x03, 0x01, 0x00, 0xff,
+    });
+
+    // has_ flags decide presence, not values
+    msg.has_s32 = false;
+    msg.has_color = false;
+    msg.has_d = false;
+    msg.has_u64 = false;
+    msg.has_f32 = false;
+    msg.has_flag = false;
+    msg.has_data = false;
+    msg.inner = nullptr;
+    CheckGolden<ScalarsEncoder>(msg, {0x08, 0x96, 0x01, 0x4a, 0x04, 0x6c, 0x61, 0x6d, 0x70});
+}
+
+/** proto3 skips zeros, but -0.0 and NaN are kept */
+void TestImplicit()
+{
+    Implicit msg = {};
+    CheckGolden<ImplicitEncoder>(msg, {});
+
+    char empty[] = "";
+    msg.s = empty;
+    CheckGolden<ImplicitEncoder>(msg, {});
+
+    uint32_t packed[] = {1, 128};
+    msg.i32 = -5;
+    msg.d = -0.0;
+    msg.n_packed = 2;
+    msg.packed = packed;
+    msg.f = std::numeric_limits<float>::quiet_NaN();
+    CheckGolden<ImplicitEncoder>(msg, {
+        0x08, 0xfb, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        0x11, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x80,
+        0x22, 0x03, 0x01, 0x80, 0x01,
+        0x2d, 0x00, 0x00, 0xc0, 0x7f,
+    });
+
+    // empty packed field isn't written at all
+    char x[] = "x";
+    msg = {};
+    msg.s = x;
+    msg.packed = packed;
+    CheckGolden<ImplicitEncoder>(msg, {0x1a, 0x01, 0x78});
+}
+
+ProtobufCFieldDescriptor Field(uint32_t id, ProtobufCLabel label, ProtobufCType type,
+                               std::size_t quantifier_offset, std::size_t offset, uint32_t flags = 0)
+{
+    ProtobufCFieldDescriptor field = {};
+    field.id = id;
+    field.label = label;
+    field.type = type;
+    field.quantifier_offset = quantifier_offset;
+    field.offset = offset;
+    field.flags = flags;
+    return field;
+}
+
+/** Descriptor as protoc-c generates it */
+void TestMatchesDescriptor()
+{
+    const auto OPTIONAL = PROTOBUF_C_LABEL_OPTIONAL;
+    ProtobufCFieldDescriptor fields[] = {
+        Field(1, PROTOBUF_C_LABEL_REQUIRED, PROTOBUF_C_TYPE_INT32, 0, offsetof(Scalars, i32)),
+        Field(2, OPTIONAL, PROTOBUF_C_TYPE_SINT32, offsetof(Scalars, has_s32), offsetof(Scalars, s32)),
+        Field(3, OPTIONAL, PROTOBUF_C_TYPE_SINT64, offsetof(Scalars, has_s64), offsetof(Scalars, s64)),
+        Field(4, OPTIONAL, PROTOBUF_C_TYPE_ENUM, offsetof(Scalars, has_color), offsetof(Scalars, color)),
+        Field(5, OPTIONAL, PROTOBUF_C_TYPE_DOUBLE, offsetof(Scalars, has_d), offsetof(Scalars, d)),
+        Field(6, OPTIONAL, PROTOBUF_C_TYPE_UINT64, offsetof(Scalars, has_u64), offsetof(Scalars, u64)),
+        Field(7, OPTIONAL, PROTOBUF_C_TYPE_FIXED32, offsetof(Scalars, has_f32), offsetof(Scalars, f32)),
+        Field(8, OPTIONAL, PROTOBUF_C_TYPE_BOOL, offsetof(Scalars, has_flag), offsetof(Scalars, flag)),
+        Field(9, PROTOBUF_C_LABEL_REQUIRED, PROTOBUF_C_TYPE_STRING, 0, offsetof(Scalars, name)),
+        Field(10, OPTIONAL, PROTOBUF_C_TYPE_MESSAGE, 0, offsetof(Scalars, inner)),
+        Field(11, OPTIONAL, PROTOBUF_C_TYPE_BYTES, offsetof(Scalars, has_data), offsetof(Scalars, data)),
+        Field(12, PROTOBUF_C_LABEL_REPEATED, PROTOBUF_C_TYPE_INT32,
+              offsetof(Scalars, n_unpacked), offsetof(Scalars, unpacked)),
+        Field(13, PROTOBUF_C_LABEL_REPEATED, PROTOBUF_C_TYPE_SINT32,
+              offsetof(Scalars, n_packed), offsetof(Scalars, packed), PROTOBUF_C_FIELD_FLAG_PACKED),
+        Field(14, PROTOBUF_C_LABEL_REPEATED, PROTOBUF_C_TYPE_MESSAGE,
+              offsetof(Scalars, n_items), offsetof(Scalars, items)),
+    };
+    ProtobufCMessageDescriptor descriptor = {};
+    descriptor.n_fields = sizeof(fields) / sizeof(fields[0]);
+    descriptor.fields = fields;
+
+    unsigned int mismatch = 100;
+    CHECK(ScalarsEncoder::Matches(descriptor, &mismatch));
+    CHECK_EQ(mismatch, 100u);
+
+    fields[4].offset = offsetof(Scalars, u64);
+    CHECK(!ScalarsEncoder::Matches(descriptor, &mismatch));
+    CHECK_EQ(mismatch, 4u);
+    fields[4].offset = offsetof(Scalars, d);
+
+    fields[12].flags = 0;
+    CHECK(!ScalarsEncoder::Matches(descriptor, &mismatch));
+    CHECK_EQ(mismatch, 12u);
+    fields[12].flags = PROTOBUF_C_FIELD_FLAG_PACKED;
+
+    // field missing in table
+    descriptor.n_fields += 1;
+    CHECK(!ScalarsEncoder::Matches(descriptor, &mismatch));
+    CHECK_EQ(mismatch, 14u);
+
+    ProtobufCFieldDescriptor implicit_fields[] = {
+        Field(1, PROTOBUF_C_LABEL_NONE, PROTOBUF_C_TYPE_INT32, 0, offsetof(Implicit, i32)),
+        Field(2, PROTOBUF_C_LABEL_NONE, PROTOBUF_C_TYPE_DOUBLE, 0, offsetof(Implicit, d)),
+        Field(3, PROTOBUF_C_LABEL_NONE, PROTOBUF_C_TYPE_STRING, 0, offsetof(Implicit, s)),
+        Field(4, PROTOBUF_C_LABEL_REPEATED, PROTOBUF_C_TYPE_UINT32,
+              offsetof(Implicit, n_packed), offsetof(Implicit, packed), PROTOBUF_C_FIELD_FLAG_PACKED),
+        Field(5, PROTOBUF_C_LABEL_NONE, PROTOBUF_C_TYPE_FLOAT, 0, offsetof(Implicit, f)),
+    };
+    ProtobufCMessageDescriptor implicit = {};
+    implicit.n_fields = sizeof(implicit_fields) / sizeof(implicit_fields[0]);
+    implicit.fields = implicit_fields;
+    CHECK(ImplicitEncoder::Matches(implicit));
+}
+
+void Benchmark()
+{
+    Inner first = {};
+    first.has_a = true;
+    first.a = -3;
+    Inner* items[] = {&first, &first};
+    int32_t unpacked[] = {-2, 300};
+    int32_t packed[] = {0, -1, 1, -64, 64};
+    char name[] = "lamp";
+
+    Scalars msg = {};
+    msg.i32 = 1000;
+    msg.has_s32 = true;
+    msg.s32 = -100;
+    msg.has_d = true;
+    msg.d = 0.5;
+    msg.has_flag = true;
+    msg.flag = true;
+    msg.name = name;
+    msg.n_unpacked = 2;
+    msg.unpacked = unpacked;
+    msg.n_packed = 5;
+    msg.packed = packed;
+    msg.n_items = 2;
+    msg.items = items;
+
+    uint8_t buffer[128];
+    uint32_t sum = 0;
+    check::Benchmark("ScalarsEncoder::PackTo per message", 1 << 20, [&](unsigned int idx) {
+        msg.i32 = static_cast<int32_t>(idx);
+        sum += ScalarsEncoder::PackTo(msg, buffer, sizeof(buffer));
+    });
+
+    Implicit implicit = {};
+    implicit.i32 = 7;
+    implicit.d = 2.5;
+    implicit.s = name;
+    check::Benchmark("ImplicitEncoder::PackTo per message", 1 << 20, [&](unsigned int idx) {
+        implicit.i32 = static_cast<int32_t>(idx);
+        sum += ImplicitEncoder::PackTo(implicit, buffer, sizeof(buffer));
+    });
+    std::printf("BENCH checksum %u\n", sum);
+}
+
+}
+
+int main()
+{
+    TestRequiredOnly();
+    TestNegativeAndRepeated();
+    TestNanAndNested();
+    TestImplicit();
+    TestMatchesDescriptor();
+    Benchmark();
+    return check::Finish("test_protobuf_encoder");
+}
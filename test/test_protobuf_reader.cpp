@@ -0,0 +1,231 @@
+// Host test and benchmark of ProtoReader on hand-encoded wire buffers
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_protobuf_reader.cpp protobuf_reader.cpp
+
+#include "espp/protobuf_reader.h"
+
+#include <cmath>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using espp::ProtoReader;
+using espp::ProtoWireType;
+
+ProtoReader Reader(const std::vector<uint8_t>& data)
+{
+    return {data.data(), data.size()};
+}
+
+void TestWireTypes()
+{
+    const std::vector<uint8_t> data = {
+        // 1: varint 150
+        0x08, 0x96, 0x01,
+        // 2: fixed64 -2
+        0x11, 0xfe, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+        // 3: string "abc"
+        0x1a, 0x03, 0x61, 0x62, 0x63,
+        // 4: fixed32 1.5f
+        0x25, 0x00, 0x00, 0xc0, 0x3f,
+        // 5: sint32 -3
+        0x28, 0x05,
+        // 6: int32 -1 as 10 bytes
+        0x30, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+        // 7: empty bytes
+        0x3a, 0x00,
+        // 1000: bool true
+        0xc0, 0x3e, 0x01,
+        // 9: double -0.25
+        0x49, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd0, 0xbf,
+        // 10: sint64 min
+        0x50, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01,
+    };
+    ProtoReader reader = Reader(data);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 1u);
+    CHECK(reader.wireType() == ProtoWireType::varint);
+    CHECK_EQ(reader.uint32(), 150u);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 2u);
+    CHECK(reader.wireType() == ProtoWireType::fixed64);
+    CHECK_EQ(reader.sfixed64(), -2);
+    CHECK_EQ(reader.bytes().length(), 8u);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 3u);
+    CHECK(reader.wireType() == ProtoWireType::length_delimited);
+    CHECK(reader.bytes().str() == "abc");
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 4u);
+    CHECK(reader.wireType() == ProtoWireType::fixed32);
+    CHECK(reader.float32() == 1.5f);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 5u);
+    CHECK_EQ(reader.sint32(), -3);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 6u);
+    CHECK_EQ(reader.int32(), -1);
+    CHECK_EQ(reader.int64(), -1);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 7u);
+    CHECK_EQ(reader.bytes().length(), 0u);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 1000u);
+    CHECK(reader.boolean());
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 9u);
+    CHECK(reader.float64() == -0.25);
+
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 10u);
+    CHECK_EQ(reader.sint64(), INT64_MIN);
+
+    CHECK(!reader.Next());
+    CHECK(!reader.hasError());
+}
+
+void TestNestedAndFind()
+{
+    const std::vector<uint8_t> data = {
+        0x08, 0x01,
+        // 2: nested {1: 42, 2: "x", 3: nested {1: 7}}
+        0x12, 0x09, 0x08, 0x2a, 0x12, 0x01, 0x78, 0x1a, 0x02, 0x08, 0x07,
+        0x18, 0x03,
+    };
+    ProtoReader reader = Reader(data);
+    CHECK(reader.Find(2));
+    ProtoReader nested = reader.nested();
+    CHECK(nested.Next());
+    CHECK_EQ(nested.field(), 1u);
+    CHECK_EQ(nested.uint32(), 42u);
+    CHECK(nested.Next());
+    CHECK(nested.bytes().str() == "x");
+    CHECK(nested.Find(3));
+    ProtoReader inner = nested.nested();
+    CHECK(inner.Next());
+    CHECK_EQ(inner.uint32(), 7u);
+    CHECK(!inner.Next());
+    CHECK(!nested.Next());
+    CHECK(!nested.hasError());
+
+    // outer reader continues after nested message
+    CHECK(reader.Next());
+    CHECK_EQ(reader.field(), 3u);
+    CHECK_EQ(reader.uint32(), 3u);
+    CHECK(!reader.Next());
+
+    ProtoReader missing = Reader(data);
+    CHECK(!missing.Find(5));
+    CHECK(!missing.hasError());
+}
+
+/** Reader stops with error on malformed data and doesn't read past buffer */
+void TestMalformed()
+{
+    const std::vector<std::vector<uint8_t>> broken = {
+        // truncated tag
+        {0x80},
+        // truncated varint
+        {0x08, 0x96},
+        // varint longer than 10 bytes
+        {0x08, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01},
+        // length above buffer
+        {0x1a, 0x05, 0x61},
+        // truncated length
+        {0x1a, 0x80},
+        // truncated fixed32 and fixed64
+        {0x25, 0x01, 0x02},
+        {0x11, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07},
+        // field 0
+        {0x00, 0x01},
+        // group wire type
+        {0x0b, 0x0c},
+    };
+    for(const auto& data: broken) {
+        // copy into exact size buffer, so reading past it is caught by sanitizers
+        std::vector<uint8_t> exact(data);
+        exact.shrink_to_fit();
+        ProtoReader reader = Reader(exact);
+        CHECK(!reader.Next());
+        CHECK(reader.hasError());
+        CHECK(!reader.Next());
+    }
+
+    // error after valid field
+    const std::vector<uint8_t> tail = {0x08, 0x01, 0x10};
+    ProtoReader reader = Reader(tail);
+    CHECK(reader.Next());
+    CHECK(!reader.hasError());
+    CHECK(!reader.Next());
+    CHECK(reader.hasError());
+
+    const std::vector<uint8_t> empty;
+    ProtoReader empty_reader = Reader(empty);
+    CHECK(!empty_reader.Next());
+    CHECK(!empty_reader.hasError());
+}
+
+void TestValuesBeforeNext()
+{
+    const std::vector<uint8_t> data = {0x1a, 0x01, 0x61};
+    ProtoReader reader = Reader(data);
+    CHECK_EQ(reader.bytes().length(), 0u);
+    CHECK(!reader.nested().Next());
+
+    ProtoReader null_reader(nullptr, 0);
+    CHECK_EQ(null_reader.bytes().length(), 0u);
+    CHECK(!null_reader.Next());
+    CHECK(!null_reader.hasError());
+}
+
+void Benchmark()
+{
+    // state-like message: 8 varints, 2 fixed, 2 strings and nested message
+    const std::vector<uint8_t> data = {
+        0x08, 0x96, 0x01, 0x10, 0x01, 0x18, 0xff, 0x01, 0x20, 0x00, 0x28, 0x05, 0x30, 0xe8, 0x07,
+        0x38, 0x80, 0x80, 0x04, 0x40, 0x01,
+        0x4d, 0x00, 0x00, 0xc0, 0x3f,
+        0x51, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xd0, 0xbf,
+        0x5a, 0x04, 0x6c, 0x61, 0x6d, 0x70,
+        0x62, 0x0b, 0x6c, 0x69, 0x76, 0x69, 0x6e, 0x67, 0x5f, 0x72, 0x6f, 0x6f, 0x6d,
+        0x6a, 0x04, 0x08, 0x2a, 0x10, 0x07,
+    };
+    uint64_t sum = 0;
+    unsigned int fields = 0;
+    check::Benchmark("ProtoReader per message", 1 << 20, [&](unsigned int) {
+        ProtoReader reader = Reader(data);
+        while(reader.Next()) {
+            fields += 1;
+            if(reader.wireType() == ProtoWireType::length_delimited) {
+                sum += reader.bytes().length();
+            } else {
+                sum += reader.varint();
+            }
+        }
+    });
+    CHECK_EQ(fields, 13u << 20);
+    std::printf("BENCH checksum %llu\n", static_cast<unsigned long long>(sum));
+}
+
+}
+
+int main()
+{
+    TestWireTypes();
+    TestNestedAndFind();
+    TestMalformed();
+    TestValuesBeforeNext();
+    Benchmark();
+    return check::Finish("test_protobuf_reader");
+}
@@ -0,0 +1,207 @@
+// Host test of pulse decoders on edge traces
+//
+//      g++ -std=gnu++11 -O2 -I include -I test test/test_pulse_decoder.cpp
+
+#include "espp/pulse_decoder.h"
+
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using espp::Edge;
+
+const uint32_t CPU_MHZ = 80;
+const uint8_t IR_PIN = 5;
+const uint8_t OTHER_PIN = 4;
+
+/**
+ * Edges of pin like EdgeCapture pushes them: first edge starts mark (low level of IR receiver),
+ * then levels alternate after each duration.
+ */
+std::vector<Edge> Trace(uint32_t start, const std::vector<uint32_t>& durations_us, uint8_t pin = IR_PIN)
+{
+    std::vector<Edge> edges;
+    uint32_t ccount = start;
+    uint8_t level = 0;
+    edges.push_back({ccount, pin, level});
+    for(uint32_t duration: durations_us) {
+        ccount += duration * CPU_MHZ;
+        level ^= 1;
+        edges.push_back({ccount, pin, level});
+    }
+    return edges;
+}
+
+/**
+ * Mark and space durations of NEC frame for 32 bits LSB first. Receiver output has
+ * longer marks and shorter spaces than nominal, so trace has them skewed by 60 us
+ */
+std::vector<uint32_t> NecFrame(uint32_t data)
+{
+    std::vector<uint32_t> durations = {9060, 4440};
+    for(unsigned int bit = 0; bit < 32; ++bit) {
+        durations.push_back(bit % 3 == 0 ? 620 : 600);
+        durations.push_back((data >> bit) & 1 ? 1630 : 510);
+    }
+    // stop bit
+    durations.push_back(620);
+    return durations;
+}
+
+std::vector<uint32_t> NecRepeat()
+{
+    return {9050, 2200, 610};
+}
+
+/** Feed edges of IR pin, return number of decoded frames and repeats */
+unsigned int Replay(espp::NecDecoder& decoder, const std::vector<Edge>& edges, uint32_t* data = nullptr,
+                    unsigned int* repeats = nullptr)
+{
+    unsigned int decoded = 0;
+    for(const Edge& edge: edges) {
+        // capture interleaves edges of all pins
+        if(edge.pin != IR_PIN || !decoder.Feed(edge)) {
+            continue;
+        }
+        decoded += 1;
+        if(decoder.isRepeat()) {
+            if(repeats != nullptr) {
+                *repeats += 1;
+            }
+        } else if(data != nullptr) {
+            *data = decoder.data();
+        }
+    }
+    return decoded;
+}
+
+/** Merge two traces by time as they are pushed by capture */
+std::vector<Edge> Interleave(const std::vector<Edge>& a, const std::vector<Edge>& b)
+{
+    std::vector<Edge> result;
+    std::size_t ia = 0;
+    std::size_t ib = 0;
+    while(ia < a.size() || ib < b.size()) {
+        const bool take_a = ib == b.size()
+            || (ia < a.size() && static_cast<int32_t>(a[ia].ccount - b[ib].ccount) <= 0);
+        result.push_back(take_a ? a[ia++] : b[ib++]);
+    }
+    return result;
+}
+
+void TestNecFrameAndRepeat()
+{
+    // address 0x00, command 0x45 and their inverses
+    const uint32_t frame = 0xBA45FF00;
+    auto durations = NecFrame(frame);
+    // 40 ms gap, then repeat code
+    durations.push_back(40000);
+    const auto repeat = NecRepeat();
+    durations.insert(durations.end(), repeat.begin(), repeat.end());
+    const auto edges = Interleave(Trace(1000, durations),
+                                  Trace(1500, {5000, 5000, 5000, 5000, 5000, 5000}, OTHER_PIN));
+
+    espp::NecDecoder decoder(CPU_MHZ);
+    uint32_t data = 0;
+    unsigned int repeats = 0;
+    CHECK_EQ(Replay(decoder, edges, &data, &repeats), 2u);
+    CHECK_EQ(data, frame);
+    CHECK_EQ(repeats, 1u);
+    CHECK_EQ(decoder.address(), 0x00);
+    CHECK_EQ(decoder.command(), 0x45);
+    CHECK_EQ(decoder.errors(), 0u);
+}
+
+void TestNecChecksumError()
+{
+    // inverse command has one wrong bit
+    espp::NecDecoder decoder(CPU_MHZ);
+    CHECK_EQ(Replay(decoder, Trace(0, NecFrame(0xBB45FF00))), 0u);
+    CHECK_EQ(decoder.errors(), 1u);
+    CHECK_EQ(decoder.data(), 0u);
+}
+
+/** Frame stops after 10 bits, after long silence the next frame is decoded */
+void TestNecTimeoutMidFrame()
+{
+    auto durations = NecFrame(0xF708FB04);
+    durations.resize(2 + 2 * 10);
+    durations.back() = 100000;
+    const auto frame = NecFrame(0xF708FB04);
+    durations.insert(durations.end(), frame.begin(), frame.end());
+
+    espp::NecDecoder decoder(CPU_MHZ);
+    uint32_t data = 0;
+    CHECK_EQ(Replay(decoder, Trace(0, durations), &data), 1u);
+    CHECK_EQ(data, 0xF708FB04u);
+    CHECK_EQ(decoder.address(), 0x04);
+    CHECK_EQ(decoder.command(), 0x08);
+    CHECK_EQ(decoder.errors(), 1u);
+}
+
+/** Cycle counter wraps in the middle of frame */
+void TestNecCcountWrap()
+{
+    const uint32_t frame = 0xE51AFE01;
+    espp::NecDecoder decoder(CPU_MHZ);
+    uint32_t data = 0;
+    const auto edges = Trace(0xFFFFFFFFu - 30000 * CPU_MHZ, NecFrame(frame));
+    CHECK(edges.front().ccount > edges.back().ccount);
+    CHECK_EQ(Replay(decoder, edges, &data), 1u);
+    CHECK_EQ(data, frame);
+    CHECK_EQ(decoder.errors(), 0u);
+}
+
+void TestFrequencyMeter()
+{
+    // 1 kHz square wave, window across counter wrap
+    const uint32_t period = 80000;
+    espp::FrequencyMeter meter;
+    uint32_t ccount = 0xFFFFFFFFu - 5 * period;
+    for(unsigned int idx = 0; idx < 11; ++idx) {
+        meter.Feed({ccount, IR_PIN, 1});
+        meter.Feed({ccount + period / 2, IR_PIN, 0});
+        ccount += period;
+    }
+    CHECK_EQ(meter.count(), 11u);
+    CHECK_EQ(meter.frequency_mhz(CPU_MHZ * 1000000), 1000000u);
+
+    // next window of 2.5 kHz
+    meter.Reset();
+    CHECK_EQ(meter.frequency_mhz(CPU_MHZ * 1000000), 0u);
+    for(unsigned int idx = 0; idx < 6; ++idx) {
+        meter.Feed({ccount, IR_PIN, 1});
+        ccount += 32000;
+    }
+    CHECK_EQ(meter.frequency_mhz(CPU_MHZ * 1000000), 2500000u);
+}
+
+void TestPulseWidth()
+{
+    espp::PulseWidth width;
+    uint32_t ccount = 0xFFFFFF00;
+    for(unsigned int idx = 0; idx < 4; ++idx) {
+        width.Feed({ccount, IR_PIN, 1});
+        width.Feed({ccount + 250, IR_PIN, 0});
+        ccount += 1000;
+    }
+    CHECK_EQ(width.high(), 250u);
+    CHECK_EQ(width.low(), 750u);
+    CHECK_EQ(width.period(), 1000u);
+    CHECK_EQ(width.duty_permille(), 250u);
+}
+
+}
+
+int main()
+{
+    TestNecFrameAndRepeat();
+    TestNecChecksumError();
+    TestNecTimeoutMidFrame();
+    TestNecCcountWrap();
+    TestFrequencyMeter();
+    TestPulseWidth();
+    return check::Finish("test_pulse_decoder");
+}
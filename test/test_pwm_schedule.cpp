@@ -0,0 +1,153 @@
+// Host test of PwmSchedule
+//
+//      g++ -std=gnu++11 -I include -I test test/test_pwm_schedule.cpp
+
+#include "espp/pwm_schedule.h"
+
+#include <algorithm>
+#include <random>
+
+#include "check.h"
+
+namespace {
+
+using espp::PwmSchedule;
+
+/** Time when channel goes low by schedule, period if it stays high, 0 if it's never high */
+uint32_t LowAt(const PwmSchedule& schedule, uint32_t mask)
+{
+    if((schedule.low_mask() & mask) != 0) {
+        return (schedule.high_mask() & mask) != 0 ? UINT32_MAX : 0;
+    }
+    if((schedule.high_mask() & mask) == 0) {
+        return UINT32_MAX;
+    }
+    uint32_t result = schedule.period();
+    for(std::size_t idx = 0; idx < schedule.size(); ++idx) {
+        if((schedule[idx].mask & mask) != 0) {
+            // channel has to go low only once
+            CHECK_EQ(result, schedule.period());
+            result = schedule[idx].at;
+        }
+    }
+    return result;
+}
+
+void TestZeroAndFull()
+{
+    const uint32_t masks[] = {0x1, 0x2, 0x4};
+    const uint32_t on_times[] = {0, 1000, 5000};
+    PwmSchedule schedule;
+    schedule.Build(masks, on_times, 3, 1000);
+    CHECK_EQ(schedule.low_mask(), 0x1u);
+    CHECK_EQ(schedule.high_mask(), 0x6u);
+    CHECK_EQ(schedule.size(), 0u);
+    CHECK_EQ(schedule.first_delay(), 1000u);
+    CHECK_EQ(LowAt(schedule, 0x1), 0u);
+    CHECK_EQ(LowAt(schedule, 0x2), 1000u);
+    CHECK_EQ(LowAt(schedule, 0x4), 1000u);
+}
+
+void TestMergeEqualTimes()
+{
+    const uint32_t masks[] = {0x1, 0x2, 0x4, 0x8};
+    const uint32_t on_times[] = {600, 200, 600, 200};
+    PwmSchedule schedule;
+    schedule.Build(masks, on_times, 4, 1000);
+    CHECK_EQ(schedule.size(), 2u);
+    CHECK_EQ(schedule[0].at, 200u);
+    CHECK_EQ(schedule[0].mask, 0xAu);
+    CHECK_EQ(schedule[1].at, 600u);
+    CHECK_EQ(schedule[1].mask, 0x5u);
+    CHECK_EQ(schedule.first_delay(), 200u);
+    CHECK_EQ(schedule.delay_after(0), 400u);
+    CHECK_EQ(schedule.delay_after(1), 400u);
+}
+
+void TestMinStep()
+{
+    const uint32_t masks[] = {0x1, 0x2, 0x4, 0x8};
+    PwmSchedule schedule;
+
+    // closer than min_step is merged into earlier step, exactly min_step apart isn't
+    const uint32_t close[] = {100, 104, 109, 500};
+    schedule.Build(masks, close, 4, 1000, 5);
+    CHECK_EQ(schedule.size(), 3u);
+    CHECK_EQ(schedule[0].at, 100u);
+    CHECK_EQ(schedule[0].mask, 0x3u);
+    CHECK_EQ(schedule[1].at, 109u);
+    CHECK_EQ(schedule[1].mask, 0x4u);
+    CHECK_EQ(schedule[2].at, 500u);
+
+    // timer can't fire sooner than min_step after period start
+    const uint32_t early[] = {1, 3, 0, 1000};
+    schedule.Build(masks, early, 4, 1000, 10);
+    CHECK_EQ(schedule.size(), 1u);
+    CHECK_EQ(schedule[0].at, 10u);
+    CHECK_EQ(schedule[0].mask, 0x3u);
+    CHECK_EQ(schedule.low_mask(), 0x4u);
+    CHECK_EQ(schedule.high_mask(), 0xBu);
+
+    // step closer than min_step to period end is dropped, channel stays high
+    const uint32_t late[] = {500, 995, 0, 0};
+    schedule.Build(masks, late, 4, 1000, 10);
+    CHECK_EQ(schedule.size(), 1u);
+    CHECK_EQ(schedule[0].at, 500u);
+    CHECK_EQ(LowAt(schedule, 0x2), 1000u);
+}
+
+/** Every channel goes low within min_step of requested time and steps are min_step apart */
+void TestRandomAgainstReference()
+{
+    std::mt19937 random(5);
+    uint32_t masks[PwmSchedule::MAX_CHANNELS];
+    uint32_t on_times[PwmSchedule::MAX_CHANNELS];
+    for(std::size_t channel = 0; channel < PwmSchedule::MAX_CHANNELS; ++channel) {
+        masks[channel] = 1u << channel;
+    }
+    PwmSchedule schedule;
+    for(unsigned int round = 0; round < 20000; ++round) {
+        const uint32_t period = 100 + random() % 2000;
+        const uint32_t min_step = round % 2 == 0 ? 0 : random() % 40;
+        const std::size_t count = 1 + random() % PwmSchedule::MAX_CHANNELS;
+        for(std::size_t channel = 0; channel < count; ++channel) {
+            const uint32_t kind = random() % 8;
+            on_times[channel] = kind == 0 ? 0 : kind == 1 ? period + random() % 10 : random() % period;
+        }
+        schedule.Build(masks, on_times, count, period, min_step);
+
+        uint32_t total = schedule.first_delay();
+        for(std::size_t idx = 0; idx < schedule.size(); ++idx) {
+            CHECK(schedule[idx].mask != 0);
+            if(idx > 0) {
+                CHECK(schedule[idx].at - schedule[idx - 1].at >= std::max<uint32_t>(min_step, 1));
+            }
+            CHECK(period - schedule[idx].at >= min_step);
+            total += schedule.delay_after(idx);
+        }
+        CHECK_EQ(total, period);
+
+        for(std::size_t channel = 0; channel < count; ++channel) {
+            const uint32_t requested = std::min(on_times[channel], period);
+            const uint32_t low_at = LowAt(schedule, masks[channel]);
+            if(min_step == 0 || requested == 0 || requested == period) {
+                CHECK_EQ(low_at, requested);
+            } else {
+                // clamp or merge into earlier step moves edge, tail merge moves it to period end
+                const uint32_t error = low_at > requested ? low_at - requested : requested - low_at;
+                CHECK(error < min_step || (low_at == period && period - requested < 2 * min_step));
+            }
+        }
+    }
+}
+
+}
+
+int main()
+{
+    TestZeroAndFull();
+    TestMergeEqualTimes();
+    TestMinStep();
+    TestRandomAgainstReference();
+    return check::Finish("test_pwm_schedule");
+}
@@ -0,0 +1,204 @@
+// Host stress test and throughput benchmark of SpscQueue and MpscQueue on FreeRTOS shim
+//
+//      g++ -std=gnu++11 -pthread -O2 -I include -I test/shim -I test test/test_ring_queue.cpp test/shim/shim.cpp
+
+#include "espp/ring_queue.h"
+
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double NsPerItem(Clock::time_point start, unsigned int count)
+{
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / count;
+}
+
+void TestSpscBasics()
+{
+    espp::SpscQueue<uint32_t, 8> queue;
+    CHECK(queue.empty());
+    const uint32_t items[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    CHECK_EQ(queue.Push(items, 10), 8u);
+    CHECK_EQ(queue.size(), 8u);
+    CHECK(!queue.Push(items[0]));
+    uint32_t popped[10] = {};
+    CHECK_EQ(queue.Pop(popped, 5), 5u);
+    CHECK_EQ(popped[4], 5u);
+
+    // claimed space stops at wrap
+    std::size_t count;
+    uint32_t* write = queue.ClaimWrite(count);
+    CHECK_EQ(count, 5u);
+    write[0] = 100;
+    queue.CommitWrite(1);
+    CHECK_EQ(queue.Pop(popped, 10), 4u);
+    CHECK_EQ(popped[0], 6u);
+    CHECK_EQ(popped[3], 100u);
+    CHECK(queue.empty());
+}
+
+void TestMpscBasics()
+{
+    espp::MpscQueue<uint32_t, 8> queue;
+    CHECK(queue.empty());
+    uint32_t first;
+    uint32_t second;
+    CHECK(queue.Claim(3, first));
+    CHECK(queue.Claim(2, second));
+    CHECK_EQ(queue.size(), 5u);
+    // second batch committed first isn't visible until first one is
+    for(uint32_t idx = 0; idx < 2; ++idx) {
+        queue.item(second + idx) = 20 + idx;
+    }
+    queue.Commit(second, 2);
+    CHECK(queue.empty());
+    for(uint32_t idx = 0; idx < 3; ++idx) {
+        queue.item(first + idx) = 10 + idx;
+    }
+    queue.Commit(first, 3);
+    uint32_t popped[8] = {};
+    CHECK_EQ(queue.Pop(popped, 8), 5u);
+    CHECK_EQ(popped[0], 10u);
+    CHECK_EQ(popped[2], 12u);
+    CHECK_EQ(popped[3], 20u);
+    CHECK_EQ(popped[4], 21u);
+
+    const uint32_t items[9] = {};
+    CHECK(!queue.Push(items, 9));
+    CHECK(queue.Push(items, 8));
+    CHECK_EQ(queue.dropped(), 1u);
+    CHECK_EQ(queue.size(), 8u);
+}
+
+/** Producer pushes increasing values in random batches, consumer checks order */
+void TestSpscStress()
+{
+    static espp::SpscQueue<uint32_t, 64> queue;
+    const uint32_t total = 500000;
+    std::thread producer([total]() {
+        std::mt19937 random(3);
+        uint32_t batch[16];
+        uint32_t next = 0;
+        while(next < total) {
+            std::size_t count = std::min<uint32_t>(random() % 16 + 1, total - next);
+            for(std::size_t idx = 0; idx < count; ++idx) {
+                batch[idx] = next + idx;
+            }
+            const std::size_t pushed = queue.Push(batch, count);
+            if(pushed == 0) {
+                std::this_thread::yield();
+            }
+            next += pushed;
+        }
+    });
+    const auto start = Clock::now();
+    uint32_t expected = 0;
+    bool is_ordered = true;
+    while(expected < total) {
+        if(!queue.Wait(pdMS_TO_TICKS(1000))) {
+            break;
+        }
+        std::size_t count;
+        const uint32_t* data = queue.ClaimRead(count);
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            is_ordered = is_ordered && data[idx] == expected;
+            expected += 1;
+        }
+        queue.CommitRead(count);
+    }
+    const double ns = NsPerItem(start, total);
+    producer.join();
+    CHECK(is_ordered);
+    CHECK_EQ(expected, total);
+    CHECK(queue.empty());
+    std::printf("BENCH SpscQueue<uint32_t, 64> throughput: %.1f ns/item\n", ns);
+}
+
+/** Producers push (producer, sequence) pairs, consumer checks per producer order */
+void TestMpscStress()
+{
+    static espp::MpscQueue<uint32_t, 64> queue;
+    const unsigned int producers = 4;
+    const uint32_t per_producer = 100000;
+    std::vector<std::thread> threads;
+    for(unsigned int producer = 0; producer < producers; ++producer) {
+        threads.emplace_back([producer, per_producer]() {
+            std::mt19937 random(producer);
+            uint32_t batch[4];
+            uint32_t next = 0;
+            while(next < per_producer) {
+                const std::size_t count = std::min<uint32_t>(random() % 4 + 1, per_producer - next);
+                for(std::size_t idx = 0; idx < count; ++idx) {
+                    batch[idx] = (producer << 24) | (next + idx);
+                }
+                if(queue.Push(batch, count)) {
+                    next += count;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    const auto start = Clock::now();
+    uint32_t expected[producers] = {};
+    uint32_t received = 0;
+    bool is_ordered = true;
+    uint32_t items[32];
+    while(received < producers * per_producer) {
+        if(!queue.Wait(pdMS_TO_TICKS(1000))) {
+            break;
+        }
+        const std::size_t count = queue.Pop(items, 32);
+        for(std::size_t idx = 0; idx < count; ++idx) {
+            const uint32_t producer = items[idx] >> 24;
+            is_ordered = is_ordered && producer < producers && (items[idx] & 0xFFFFFF) == expected[producer];
+            expected[producer & 3] += 1;
+        }
+        received += count;
+    }
+    const double ns = NsPerItem(start, producers * per_producer);
+    for(auto& thread: threads) {
+        thread.join();
+    }
+    CHECK(is_ordered);
+    CHECK_EQ(received, producers * per_producer);
+    CHECK(queue.empty());
+    CHECK_EQ(queue.size(), 0u);
+    std::printf("BENCH MpscQueue<uint32_t, 64> throughput with %u producers: %.1f ns/item, %u full\n",
+                producers, ns, queue.dropped());
+}
+
+void BenchmarkSingleThread()
+{
+    static espp::SpscQueue<uint32_t, 256> spsc;
+    static espp::MpscQueue<uint32_t, 256> mpsc;
+    const unsigned int count = 1000000;
+    uint32_t item = 0;
+    check::Benchmark("SpscQueue push+pop", count, [&item](unsigned int idx) {
+        spsc.Push(idx);
+        spsc.Pop(item);
+    });
+    check::Benchmark("MpscQueue push+pop", count, [&item](unsigned int idx) {
+        mpsc.Push(idx);
+        mpsc.Pop(item);
+    });
+}
+
+}
+
+int main()
+{
+    TestSpscBasics();
+    TestMpscBasics();
+    TestSpscStress();
+    TestMpscStress();
+    BenchmarkSingleThread();
+    return check::Finish("test_ring_queue");
+}
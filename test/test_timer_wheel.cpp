@@ -0,0 +1,229 @@
+// Host test and tick cost benchmark of TimerWheel on FreeRTOS shim
+//
+//      g++ -std=gnu++11 -pthread -O2 -I include -I test/shim -I test test/test_timer_wheel.cpp test/shim/shim.cpp timer_wheel.cpp log.cpp task.cpp
+
+#include "espp/timer_wheel.h"
+
+#include <atomic>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+const uint32_t MS_PER_TICK = 1000 / configTICK_RATE_HZ;
+
+TickType_t current_tick = 0;
+
+struct Probe {
+    espp::TimerWheel* wheel = nullptr;
+    espp::Timer* timer = nullptr;
+    std::vector<TickType_t> fired;
+    unsigned int cancel_after = 0;
+
+    static
+    void Callback(void* arg)
+    {
+        auto& probe = *static_cast<Probe*>(arg);
+        probe.fired.push_back(current_tick);
+        if(probe.cancel_after != 0 && probe.fired.size() == probe.cancel_after) {
+            probe.wheel->Cancel(*probe.timer);
+        }
+    }
+};
+
+/** Advance tick by tick, so fired ticks are exact */
+void AdvanceTo(espp::TimerWheel& wheel, TickType_t until)
+{
+    TickType_t next;
+    while(static_cast<int32_t>(until - current_tick) > 0) {
+        current_tick += 1;
+        wheel.Advance(current_tick, next);
+    }
+}
+
+void Arm(espp::TimerWheel& wheel, espp::Timer& timer, TickType_t delay, TickType_t period = 0)
+{
+    vShimSetTickCount(current_tick);
+    wheel.Arm(timer, delay * MS_PER_TICK, period * MS_PER_TICK);
+}
+
+void TestNoDeadline()
+{
+    espp::TimerWheel wheel;
+    TickType_t next = 0;
+    CHECK(!wheel.Advance(current_tick, next));
+
+    Probe probe;
+    espp::Timer timer(Probe::Callback, &probe);
+    Arm(wheel, timer, 5);
+    CHECK(wheel.Advance(current_tick, next));
+    CHECK(static_cast<int32_t>(next - current_tick) > 0);
+    CHECK(static_cast<int32_t>(next - (current_tick + 5)) <= 0);
+    wheel.Cancel(timer);
+    CHECK(!timer.isArmed());
+    CHECK_EQ(wheel.armed(), 0u);
+    CHECK(!wheel.Advance(current_tick, next));
+    AdvanceTo(wheel, current_tick + 10);
+    CHECK(probe.fired.empty());
+}
+
+void TestOneShotAndRearm()
+{
+    espp::TimerWheel wheel;
+    Probe probe;
+    espp::Timer timer(Probe::Callback, &probe);
+    const TickType_t start = current_tick;
+    Arm(wheel, timer, 5);
+    AdvanceTo(wheel, start + 3);
+    // rearm moves expiry
+    Arm(wheel, timer, 5);
+    CHECK_EQ(wheel.armed(), 1u);
+    AdvanceTo(wheel, start + 20);
+    CHECK_EQ(probe.fired.size(), 1u);
+    if(probe.fired.size() == 1) {
+        CHECK_EQ(probe.fired[0], start + 8);
+    }
+    CHECK(!timer.isArmed());
+    CHECK_EQ(wheel.armed(), 0u);
+}
+
+void TestPeriodicCancelInCallback()
+{
+    espp::TimerWheel wheel;
+    Probe probe;
+    espp::Timer timer(Probe::Callback, &probe);
+    probe.wheel = &wheel;
+    probe.timer = &timer;
+    probe.cancel_after = 3;
+    const TickType_t start = current_tick;
+    Arm(wheel, timer, 1, 2);
+    AdvanceTo(wheel, start + 20);
+    CHECK_EQ(probe.fired.size(), 3u);
+    if(probe.fired.size() == 3) {
+        CHECK_EQ(probe.fired[0], start + 1);
+        CHECK_EQ(probe.fired[1], start + 3);
+        CHECK_EQ(probe.fired[2], start + 5);
+    }
+    CHECK_EQ(wheel.armed(), 0u);
+    CHECK_EQ(wheel.fired(), 3u);
+}
+
+/** Random delays over all levels fire exactly on expiry tick */
+void TestRandomAgainstReference()
+{
+    espp::TimerWheel wheel;
+    const unsigned int count = 2000;
+    std::vector<Probe> probes(count);
+    std::vector<espp::Timer*> timers;
+    std::vector<TickType_t> expected(count);
+    std::mt19937 random(1);
+    std::uniform_int_distribution<TickType_t> delays(1, 300000);
+    const TickType_t start = current_tick;
+    for(unsigned int idx = 0; idx < count; ++idx) {
+        timers.push_back(new espp::Timer(Probe::Callback, &probes[idx]));
+        const TickType_t delay = idx % 4 == 0 ? delays(random) % 100 + 1 : delays(random);
+        expected[idx] = start + delay;
+        Arm(wheel, *timers[idx], delay);
+    }
+    AdvanceTo(wheel, start + 300001);
+    for(unsigned int idx = 0; idx < count; ++idx) {
+        CHECK_EQ(probes[idx].fired.size(), 1u);
+        if(probes[idx].fired.size() == 1) {
+            CHECK_EQ(probes[idx].fired[0], expected[idx]);
+        }
+        delete timers[idx];
+    }
+    CHECK_EQ(wheel.armed(), 0u);
+}
+
+void Nop(void*)
+{
+}
+
+void Count(void* arg)
+{
+    *static_cast<std::atomic<unsigned int>*>(arg) += 1;
+}
+
+/** Task blocks without deadline while idle and wakes on Arm */
+void TestRun()
+{
+    vShimReleaseTickCount();
+    // wheel is static: its task thread isn't stopped
+    static espp::TimerWheel wheel;
+    static std::atomic<unsigned int> count{0};
+    static espp::Timer timer(Count, &count);
+    CHECK(espp::Task::Start(wheel));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    wheel.Arm(timer, 20);
+    for(unsigned int waited = 0; waited < 1000 && count.load() == 0; ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK_EQ(count.load(), 1u);
+    wheel.Arm(timer, 20);
+    for(unsigned int waited = 0; waited < 1000 && count.load() == 1; ++waited) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    CHECK_EQ(count.load(), 2u);
+}
+
+void Benchmark()
+{
+    espp::TimerWheel wheel;
+    const unsigned int count = 4096;
+    std::vector<espp::Timer*> timers;
+    for(unsigned int idx = 0; idx < count; ++idx) {
+        timers.push_back(new espp::Timer(Nop));
+    }
+    std::mt19937 random(2);
+    std::vector<TickType_t> delays(count);
+    for(auto& delay: delays) {
+        delay = random() % 100000 + 1;
+    }
+    vShimSetTickCount(current_tick);
+
+    // host costs include shim critical section, a recursive mutex
+    check::Benchmark("TimerWheel::Arm", count, [&](unsigned int idx) {
+        wheel.Arm(*timers[idx], delays[idx] * MS_PER_TICK);
+    });
+    check::Benchmark("TimerWheel::Arm rearm", count, [&](unsigned int idx) {
+        wheel.Arm(*timers[idx], delays[count - 1 - idx] * MS_PER_TICK);
+    });
+    const unsigned int ticks = 100000;
+    check::Benchmark("TimerWheel::Advance per tick with 4096 armed", ticks, [&](unsigned int) {
+        TickType_t next;
+        current_tick += 1;
+        wheel.Advance(current_tick, next);
+    });
+    std::printf("BENCH TimerWheel fired %u, max batch %u\n", wheel.fired(), wheel.max_batch());
+    check::Benchmark("TimerWheel::Cancel", count, [&](unsigned int idx) {
+        wheel.Cancel(*timers[idx]);
+    });
+    check::Benchmark("TimerWheel::Advance per tick idle", ticks, [&](unsigned int) {
+        TickType_t next;
+        current_tick += 1;
+        wheel.Advance(current_tick, next);
+    });
+    for(auto* timer: timers) {
+        delete timer;
+    }
+}
+
+}
+
+int main()
+{
+    current_tick = 1000;
+    TestNoDeadline();
+    TestOneShotAndRearm();
+    TestPeriodicCancelInCallback();
+    // expiry crossing tick counter wrap
+    current_tick = static_cast<TickType_t>(0) - 150000;
+    TestRandomAgainstReference();
+    Benchmark();
+    TestRun();
+    return check::Finish("test_timer_wheel");
+}
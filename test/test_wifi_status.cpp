@@ -0,0 +1,126 @@
+// Host test of concurrent WiFiStatus transitions on FreeRTOS shim
+//
+//      g++ -std=gnu++11 -pthread -O2 -I include -I test/shim -I test test/test_wifi_status.cpp test/shim/shim.cpp
+
+#include "espp/wifi_status.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "check.h"
+
+namespace {
+
+using lamp::WiFiStatus;
+using State = WiFiStatus::State;
+
+void TestTransitions()
+{
+    WiFiStatus status;
+    CHECK(status.state() == State::none);
+    CHECK(!status.Transit(State::started, State::wait_connect));
+    CHECK(status.Transit(State::none, State::wait_start));
+    CHECK(status.Transit(State::wait_start, State::started));
+    CHECK(!status.SetIp(State::connected));
+    CHECK(!status.hasIp());
+    CHECK(status.Transit(State::started, State::wait_connect));
+    CHECK(status.Transit(State::wait_connect, State::connected));
+    CHECK(status.SetIp(State::connected));
+    CHECK(status.hasIp());
+    // IP is kept unless transition clears it
+    CHECK(status.Transit(State::connected, State::connected));
+    CHECK(status.hasIp());
+    CHECK(status.Transit(State::connected, State::started, true));
+    CHECK(!status.hasIp());
+    CHECK(status.state() == State::started);
+    status.Reset();
+    CHECK(status.state() == State::none);
+}
+
+/** Commands and events race on same transitions, only one of them can win each one */
+void TestConcurrentTransitions()
+{
+    static WiFiStatus status;
+    CHECK(status.Transit(State::none, State::wait_start));
+    CHECK(status.Transit(State::wait_start, State::started));
+
+    const unsigned int threads = 4;
+    const unsigned int cycles = 20000;
+    static std::atomic<bool> is_broken{false};
+    static std::atomic<unsigned int> connects{0};
+    // changed only by the thread which won started -> wait_connect
+    static unsigned int owned = 0;
+
+    std::vector<std::thread> workers;
+    for(unsigned int thread = 0; thread < threads; ++thread) {
+        workers.emplace_back([cycles]() {
+            unsigned int done = 0;
+            while(done < cycles && !is_broken) {
+                if(!status.Transit(State::started, State::wait_connect)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                const unsigned int before = owned;
+                owned = before + 1;
+                // events: connected, got IP, disconnected
+                const bool is_valid = status.Transit(State::wait_connect, State::connected)
+                    && status.SetIp(State::connected)
+                    && owned == before + 1
+                    && status.Transit(State::connected, State::started, true);
+                if(!is_valid) {
+                    is_broken = true;
+                }
+                connects += 1;
+                done += 1;
+            }
+        });
+    }
+    for(auto& worker: workers) {
+        worker.join();
+    }
+
+    CHECK(!is_broken);
+    CHECK_EQ(connects.load(), threads * cycles);
+    CHECK_EQ(owned, threads * cycles);
+    CHECK(status.state() == State::started);
+    CHECK(!status.hasIp());
+}
+
+/** Disconnect event races with got IP event, IP can't stay set in started state */
+void TestIpClearedByDisconnect()
+{
+    static WiFiStatus status;
+    const unsigned int cycles = 20000;
+    static std::atomic<unsigned int> stale_ip{0};
+    for(unsigned int cycle = 0; cycle < cycles; ++cycle) {
+        status.Reset();
+        status.Transit(State::none, State::started);
+        status.Transit(State::started, State::wait_connect);
+        status.Transit(State::wait_connect, State::connected);
+        std::thread got_ip([]() {
+            status.SetIp(State::connected);
+        });
+        std::thread disconnected([]() {
+            if(!status.Transit(State::connected, State::started, true)) {
+                status.ClearIp();
+            }
+        });
+        got_ip.join();
+        disconnected.join();
+        if(status.hasIp()) {
+            stale_ip += 1;
+        }
+    }
+    CHECK_EQ(stale_ip.load(), 0u);
+}
+
+}
+
+int main()
+{
+    TestTransitions();
+    TestConcurrentTransitions();
+    TestIpClearedByDisconnect();
+    return check::Finish("test_wifi_status");
+}
@@ -4,15 +4,32 @@
 #include "espp/lts.h"
 #include "espp/log.h"
 #include "espp/task.h"
+#include "espp/executor.h"
+#include "espp/coroutine.h"
+#include "espp/timer_wheel.h"
 #include "espp/gpio.h"
+#include "espp/gpio_dispatcher.h"
+#include "espp/edge_capture.h"
+#include "espp/pulse_decoder.h"
+#include "espp/pwm_schedule.h"
+#include "espp/soft_pwm.h"
 #include "espp/mutex.h"
 #include "espp/critical_section.h"
+#include "espp/ring_queue.h"
 
+#include "espp/wifi_status.h"
 #include "espp/wifi.h"
 #include "espp/mqtt.h"
+#include "espp/mqtt_protobuf.h"
 #include "espp/protobuf.h"
+#include "espp/protobuf_reader.h"
+#include "espp/protobuf_delta.h"
+#include "espp/mqtt_protobuf_delta.h"
+#include "espp/protobuf_encoder.h"
 #include "espp/buffer.h"
 #include "espp/web_server.h"
 #include "espp/web_server_html_template.h"
 
+#include "espp/lock_order.h"
 #include "espp/utils/macros.h"
+#include "espp/utils/cpu_profiler.h"
@@ -0,0 +1,166 @@
+#include "espp/timer_wheel.h"
+#include "espp/critical_section.h"
+
+namespace espp {
+
+void TimerWheel::_Link(Timer*& head, Timer& timer)
+{
+    timer._next = head;
+    if(head != nullptr) {
+        head->_pprev = &timer._next;
+    }
+    head = &timer;
+    timer._pprev = &head;
+}
+
+void TimerWheel::_Unlink(Timer& timer)
+{
+    *timer._pprev = timer._next;
+    if(timer._next != nullptr) {
+        timer._next->_pprev = timer._pprev;
+    }
+    timer._next = nullptr;
+    timer._pprev = nullptr;
+}
+
+void TimerWheel::_Insert(Timer& timer)
+{
+    auto delta = static_cast<int32_t>(timer._expires - _next_tick);
+    if(delta < 0) {
+        // already expired: fire on next processed tick
+        _Link(_slots[_next_tick & SLOT_MASK], timer);
+        return;
+    }
+    const unsigned int max_delta = (1u << (LEVEL_BITS * LEVELS)) - 1;
+    TickType_t expires = timer._expires;
+    if(static_cast<uint32_t>(delta) > max_delta) {
+        // will be cascaded again from the last level
+        expires = _next_tick + max_delta;
+        delta = max_delta;
+    }
+    unsigned int level = 0;
+    while(level + 1 < LEVELS && static_cast<uint32_t>(delta) >= (1u << (LEVEL_BITS * (level + 1)))) {
+        level += 1;
+    }
+    const unsigned int slot = (expires >> (LEVEL_BITS * level)) & SLOT_MASK;
+    _Link(_slots[level * SLOTS + slot], timer);
+}
+
+void TimerWheel::_Arm(Timer& timer, TickType_t now, TickType_t delay, TickType_t period)
+{
+    CriticalSection lock;
+    if(timer.isArmed()) {
+        _Unlink(timer);
+    } else {
+        if(_armed == 0) {
+            // wheel is idle and isn't advanced, so move it to current tick
+            _next_tick = now;
+        }
+        _armed += 1;
+    }
+    timer._expires = now + delay;
+    timer._period = period;
+    _Insert(timer);
+}
+
+void TimerWheel::Cancel(Timer& timer)
+{
+    CriticalSection lock;
+    if(!timer.isArmed()) {
+        return;
+    }
+    _Unlink(timer);
+    _armed -= 1;
+}
+
+bool TimerWheel::_Cascade(unsigned int level)
+{
+    const unsigned int slot = (_next_tick >> (LEVEL_BITS * level)) & SLOT_MASK;
+    Timer*& head = _slots[level * SLOTS + slot];
+    while(head != nullptr) {
+        Timer& timer = *head;
+        _Unlink(timer);
+        _Insert(timer);
+    }
+    return slot == 0;
+}
+
+void TimerWheel::_Fire()
+{
+    unsigned int batch = 0;
+    for(;;) {
+        Timer* timer;
+        {
+            CriticalSection lock;
+            timer = _expired;
+            if(timer == nullptr) {
+                break;
+            }
+            _Unlink(*timer);
+            if(timer->_period != 0) {
+                timer->_expires += timer->_period;
+                _Insert(*timer);
+            } else {
+                _armed -= 1;
+            }
+        }
+        timer->_callback(timer->_arg);
+        batch += 1;
+    }
+    _fired += batch;
+    if(batch > _max_batch) {
+        _max_batch = batch;
+    }
+}
+
+bool TimerWheel::Advance(TickType_t now, TickType_t& next)
+{
+    for(;;) {
+        {
+            CriticalSection lock;
+            if(_armed == 0) {
+                _next_tick = now + 1;
+                return false;
+            }
+            if(static_cast<int32_t>(now - _next_tick) < 0) {
+                // find next not empty slot or next cascade
+                for(TickType_t tick = _next_tick; ; ++tick) {
+                    if(_slots[tick & SLOT_MASK] != nullptr || (tick & SLOT_MASK) == 0) {
+                        next = tick;
+                        return true;
+                    }
+                }
+            }
+            if((_next_tick & SLOT_MASK) == 0) {
+                for(unsigned int level = 1; level < LEVELS && _Cascade(level); ++level) {
+                }
+            }
+            Timer*& head = _slots[_next_tick & SLOT_MASK];
+            while(head != nullptr) {
+                Timer& timer = *head;
+                _Unlink(timer);
+                _Link(_expired, timer);
+            }
+            _next_tick += 1;
+        }
+        _Fire();
+    }
+}
+
+void TimerWheel::run()
+{
+    for(;;) {
+        TickType_t next;
+        if(!Advance(xTaskGetTickCount(), next)) {
+            // Arm notifies, so the timer armed after Advance isn't missed
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+            continue;
+        }
+        const auto wait = static_cast<int32_t>(next - xTaskGetTickCount());
+        if(wait > 0) {
+            ulTaskNotifyTake(pdTRUE, static_cast<TickType_t>(wait));
+        }
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+#!/usr/bin/env python3
+"""Symbolize PC histogram of espp::CpuProfiler::AppendPcTo.
+
+Usage:
+    symbolize_pc.py build/app.elf histogram.txt
+    mosquitto_sub -t device/profile/pc -C 1 | symbolize_pc.py build/app.elf
+"""
+
+import argparse
+import collections
+import subprocess
+import sys
+
+
+def read_histogram(lines):
+    counts = {}
+    dropped = 0
+    for line in lines:
+        fields = line.split()
+        if len(fields) != 2:
+            continue
+        if fields[0] == 'dropped':
+            dropped = int(fields[1])
+        else:
+            counts[int(fields[0], 16)] = int(fields[1])
+    return counts, dropped
+
+
+def symbolize(addr2line, elf, pcs):
+    if not pcs:
+        return {}
+    output = subprocess.run([addr2line, '-f', '-C', '-e', elf] + ['0x%08x' % pc for pc in pcs],
+                            check=True, stdout=subprocess.PIPE, universal_newlines=True).stdout.splitlines()
+    # two lines per address: function and file:line
+    return {pc: (output[2 * idx], output[2 * idx + 1]) for idx, pc in enumerate(pcs)}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument('elf')
+    parser.add_argument('histogram', nargs='?', type=argparse.FileType('r'), default=sys.stdin)
+    parser.add_argument('--addr2line', default='xtensa-lx106-elf-addr2line')
+    parser.add_argument('--lines', action='store_true', help='report source lines instead of functions')
+    args = parser.parse_args()
+
+    counts, dropped = read_histogram(args.histogram)
+    symbols = symbolize(args.addr2line, args.elf, sorted(counts))
+    total = sum(counts.values()) + dropped
+    by_symbol = collections.Counter()
+    for pc, count in counts.items():
+        function, location = symbols[pc]
+        by_symbol[location if args.lines else function] += count
+    for symbol, count in by_symbol.most_common():
+        print('%6.2f%% %8u %s' % (100.0 * count / total, count, symbol))
+    if dropped:
+        print('%6.2f%% %8u (dropped)' % (100.0 * dropped / total, dropped))
+
+
+if __name__ == '__main__':
+    main()
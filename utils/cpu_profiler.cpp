@@ -0,0 +1,213 @@
+#include "espp/utils/cpu_profiler.h"
+#include "espp/critical_section.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "esp8266/eagle_soc.h"
+
+#ifdef ESPP_CPU_PROFILER_PC
+// first member of TCB is pxTopOfStack
+extern "C" void* volatile pxCurrentTCB;
+#endif
+
+namespace espp {
+
+namespace {
+
+CpuProfiler::Snapshot _current = {};
+CpuProfiler::PcHistogram _pcs = {};
+uint32_t _last_tick_ccount = 0;
+uint32_t _isr_start_ccount = 0;
+uint32_t _isr_cycles_since_tick = 0;
+unsigned int _isr_depth = 0;
+
+CpuProfiler::TaskUsage* _FindTask(TaskHandle_t handle)
+{
+    for(std::size_t idx = 0; idx < _current.task_count; ++idx) {
+        if(_current.tasks[idx].handle == handle) {
+            return &_current.tasks[idx];
+        }
+    }
+    if(_current.task_count == CpuProfiler::MAX_TASKS) {
+        return nullptr;
+    }
+    auto& usage = _current.tasks[_current.task_count++];
+    usage.handle = handle;
+    usage.cycles = 0;
+    const char* name = pcTaskGetName(handle);
+    std::strncpy(usage.name, name == nullptr ? "" : name, CpuProfiler::NAME_LENGTH - 1);
+    usage.name[CpuProfiler::NAME_LENGTH - 1] = 0;
+    usage.is_idle = std::strcmp(usage.name, "IDLE") == 0;
+    return &usage;
+}
+
+#ifdef ESPP_CPU_PROFILER_PC
+/** Interrupt entry saved XtExcFrame (exit, pc, ps, a0...) at top of interrupted task stack */
+uint32_t _InterruptedPc()
+{
+    const auto* frame = *static_cast<const uint32_t* const*>(pxCurrentTCB);
+    return frame[1];
+}
+#endif
+
+}
+
+void CpuProfiler::OnTick()
+{
+    const uint32_t now = soc_get_ccount();
+    if(_last_tick_ccount == 0) {
+        _last_tick_ccount = now;
+        return;
+    }
+    // ccount is 32 bit, so one delta can't wrap, totals are 64 bit
+    uint32_t cycles = now - _last_tick_ccount;
+    _last_tick_ccount = now;
+    _current.total_cycles += cycles;
+    const uint32_t isr_cycles = std::min(_isr_cycles_since_tick, cycles);
+    _isr_cycles_since_tick = 0;
+    _current.isr_cycles += isr_cycles;
+    cycles -= isr_cycles;
+
+    auto* usage = _FindTask(xTaskGetCurrentTaskHandle());
+    if(usage != nullptr) {
+        usage->cycles += cycles;
+    } else {
+        _current.other_cycles += cycles;
+    }
+#ifdef ESPP_CPU_PROFILER_PC
+    SamplePc(_InterruptedPc());
+#endif
+}
+
+void CpuProfiler::SamplePc(uint32_t pc)
+{
+    pc &= PC_MASK;
+    _pcs.samples += 1;
+    if(pc == 0) {
+        _pcs.dropped += 1;
+        return;
+    }
+    // Fibonacci hash of code address (top 7 bits for 128 slots), then linear probing
+    static_assert(PC_SLOTS == 128, "hash shift expects 128 slots");
+    const std::size_t idx = ((pc >> 4) * 2654435769u) >> 25;
+    for(std::size_t probe = 0; probe < PC_SLOTS; ++probe) {
+        auto& slot = _pcs.slots[(idx + probe) % PC_SLOTS];
+        if(slot.pc == pc) {
+            slot.count += 1;
+            return;
+        }
+        if(slot.pc == 0) {
+            slot.pc = pc;
+            slot.count = 1;
+            return;
+        }
+    }
+    _pcs.dropped += 1;
+}
+
+void CpuProfiler::IsrEnter()
+{
+    if(_isr_depth++ == 0) {
+        _isr_start_ccount = soc_get_ccount();
+    }
+}
+
+void CpuProfiler::IsrExit()
+{
+    if(--_isr_depth == 0) {
+        _isr_cycles_since_tick += soc_get_ccount() - _isr_start_ccount;
+    }
+}
+
+CpuProfiler::Snapshot CpuProfiler::TakeSnapshot(bool reset)
+{
+    CriticalSection lock;
+    const Snapshot result = _current;
+    if(reset) {
+        // keep task table, so task names aren't read again
+        for(std::size_t idx = 0; idx < _current.task_count; ++idx) {
+            _current.tasks[idx].cycles = 0;
+        }
+        _current.total_cycles = 0;
+        _current.isr_cycles = 0;
+        _current.other_cycles = 0;
+    }
+    return result;
+}
+
+void CpuProfiler::TakePcHistogram(PcHistogram& out, bool reset)
+{
+    CriticalSection lock;
+    out = _pcs;
+    if(reset) {
+        _pcs = {};
+    }
+}
+
+void CpuProfiler::AppendPcTo(const PcHistogram& histogram, std::string& out)
+{
+    char line[32];
+    for(const auto& slot: histogram.slots) {
+        if(slot.pc != 0) {
+            snprintf(line, sizeof(line), "0x%08x %u\n", slot.pc, slot.count);
+            out += line;
+        }
+    }
+    snprintf(line, sizeof(line), "dropped %u\n", histogram.dropped);
+    out += line;
+}
+
+uint64_t CpuProfiler::Snapshot::idle_cycles() const
+{
+    uint64_t result = 0;
+    for(std::size_t idx = 0; idx < task_count; ++idx) {
+        if(tasks[idx].is_idle) {
+            result += tasks[idx].cycles;
+        }
+    }
+    return result;
+}
+
+namespace {
+
+void _AppendUsage(std::string& out, const char* name, uint32_t permille)
+{
+    char line[48];
+    snprintf(line, sizeof(line), "%s %u.%u%%\n", name, permille / 10, permille % 10);
+    out += line;
+}
+
+}
+
+void CpuProfiler::Snapshot::AppendTo(std::string& out) const
+{
+    for(std::size_t idx = 0; idx < task_count; ++idx) {
+        _AppendUsage(out, tasks[idx].name, permille(tasks[idx].cycles));
+    }
+    _AppendUsage(out, "ISR", permille(isr_cycles));
+    _AppendUsage(out, "other", permille(other_cycles));
+    _AppendUsage(out, "idle", permille(idle_cycles()));
+}
+
+const Log& operator<<(const Log& log, const CpuProfiler::Snapshot& snapshot)
+{
+    log << "CPU Mcycles" << static_cast<unsigned int>(snapshot.total_cycles / 1000000);
+    for(std::size_t idx = 0; idx < snapshot.task_count; ++idx) {
+        log << "\n\t" << snapshot.tasks[idx].name << snapshot.permille(snapshot.tasks[idx].cycles);
+    }
+    return log << "\n\tISR" << snapshot.permille(snapshot.isr_cycles)
+               << "\n\tother" << snapshot.permille(snapshot.other_cycles)
+               << "\n\tidle" << snapshot.permille(snapshot.idle_cycles())
+               << "(in 0.1%)";
+}
+
+}
+
+#ifdef ESPP_CPU_PROFILER_TICK_HOOK
+extern "C" void vApplicationTickHook()
+{
+    espp::CpuProfiler::OnTick();
+}
+#endif
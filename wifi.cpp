@@ -39,7 +39,7 @@ void WiFi::SetAccessPoint(const Buffer& ssid)
 {
     INFO << "Set access point: SSID" << ssid;
     Mutex::LockGuard lock(_mutex);
-    ESPP_CHECK(_state == State::none);
+    ESPP_CHECK(state() == State::none);
     if(ssid.empty()) {
         DEBUG << "Disable access point";
         ESP_ERROR_CHECK(esp_wifi_set_mode(WIFI_MODE_STA));
@@ -63,7 +63,8 @@ void WiFi::SetConnection(const Buffer& ssid, const Buffer& password)
 {
     INFO << "Set connection to" << ssid << "with password length" << password.length();
     Mutex::LockGuard lock(_mutex);
-    ESPP_CHECK(_state == State::none || _state == State::wait_start || _state == State::started);
+    const State state = this->state();
+    ESPP_CHECK(state == State::none || state == State::wait_start || state == State::started);
     if(ssid.empty()) {
         DEBUG << "Disable station";
         _isStation = false;
@@ -81,12 +82,11 @@ bool WiFi::Start()
 {
     INFO << "Start WiFi";
     Mutex::LockGuard lock(_mutex);
-    if(_state != State::none) {
+    if(!_status.Transit(State::none, State::wait_start)) {
         DEBUG << "Invalid state";
         return false;
     }
 
-    _state = State::wait_start;
     ESP_ERROR_CHECK(esp_wifi_start());
     return true;
 }
@@ -100,22 +100,27 @@ bool WiFi::Connect()
         return false;
     }
 
-    switch(_state) {
-        case State::wait_start:
-            DEBUG << "Wait start. Append wait connection";
-            _state = State::wait_start_connect;
-            break;
-        case State::started:
-            DEBUG << "Connect station";
-            _state = State::wait_connect;
-            ESP_ERROR_CHECK(esp_wifi_connect());
-            break;
-        default:
-            DEBUG << "Invalid state";
-            return false;
+    // event handler can change state concurrently, so retry until transition succeeds
+    while(true) {
+        switch(state()) {
+            case State::wait_start:
+                if(_status.Transit(State::wait_start, State::wait_start_connect)) {
+                    DEBUG << "Wait start. Append wait connection";
+                    return true;
+                }
+                break;
+            case State::started:
+                if(_status.Transit(State::started, State::wait_connect)) {
+                    DEBUG << "Connect station";
+                    ESP_ERROR_CHECK(esp_wifi_connect());
+                    return true;
+                }
+                break;
+            default:
+                DEBUG << "Invalid state";
+                return false;
+        }
     }
-
-    return true;
 }
 
 bool WiFi::Disconnect()
@@ -126,28 +131,31 @@ bool WiFi::Disconnect()
         DEBUG << "Station isn't inited";
         return false;
     }
-    switch(_state) {
-        case State::wait_start_connect:
-            DEBUG << "Wait start and connect. Reset wait connect";
-            _state = State::wait_start;
-            break;
-        case State::wait_connect:
-        case State::connected:
-            DEBUG << "Station connected. Disconnect";
-            ESP_ERROR_CHECK(esp_wifi_disconnect());
-            break;
-        default:
-            DEBUG << "Invalid state";
-            return false;
+    while(true) {
+        switch(state()) {
+            case State::wait_start_connect:
+                if(_status.Transit(State::wait_start_connect, State::wait_start)) {
+                    DEBUG << "Wait start and connect. Reset wait connect";
+                    return true;
+                }
+                break;
+            case State::wait_connect:
+            case State::connected:
+                DEBUG << "Station connected. Disconnect";
+                ESP_ERROR_CHECK(esp_wifi_disconnect());
+                return true;
+            default:
+                DEBUG << "Invalid state";
+                return false;
+        }
     }
-    return true;
 }
 
 bool WiFi::Stop()
 {
     INFO << "Stop wifi";
     Mutex::LockGuard lock(_mutex);
-    if(_state == State::none) {
+    if(state() == State::none) {
         DEBUG << "Wifi wasn't started";
         return false;
     }
@@ -158,75 +166,63 @@ bool WiFi::Stop()
 void WiFi::OnStarted()
 {
     INFO << "On started";
-    Mutex::LockGuard lock(_mutex);
-    switch(_state) {
-        case State::wait_start:
-            DEBUG << "WiFi started";
-            _state = State::started;
-            break;
-        case State::wait_start_connect:
-            DEBUG << "WiFi started and wait connection";
-            _state = State::wait_connect;
-            ESP_ERROR_CHECK(esp_wifi_connect());
-            break;
-        default:
-            DEBUG << "Invalid state";
+    while(true) {
+        switch(state()) {
+            case State::wait_start:
+                if(_status.Transit(State::wait_start, State::started)) {
+                    DEBUG << "WiFi started";
+                    return;
+                }
+                break;
+            case State::wait_start_connect:
+                if(_status.Transit(State::wait_start_connect, State::wait_connect)) {
+                    DEBUG << "WiFi started and wait connection";
+                    ESP_ERROR_CHECK(esp_wifi_connect());
+                    return;
+                }
+                break;
+            default:
+                DEBUG << "Invalid state";
+                return;
+        }
     }
 }
 
 void WiFi::OnConnected()
 {
     INFO << "On connected";
-    Mutex::LockGuard lock(_mutex);
-    switch(_state) {
-        case State::wait_connect:
-            _state = State::connected;
-            break;
-        default:
-            ERROR << "Invalid state";
+    if(!_status.Transit(State::wait_connect, State::connected)) {
+        ERROR << "Invalid state";
     }
 }
 
 void WiFi::OnGotIp()
 {
     INFO << "On got IP";
-    Mutex::LockGuard lock(_mutex);
-    switch(_state) {
-        case State::connected:
-            _hasIp = true;
-            break;
-        default:
-            ERROR << "Invalid state";
+    if(!_status.SetIp(State::connected)) {
+        ERROR << "Invalid state";
     }
 }
 
 void WiFi::OnDisconnected()
 {
     INFO << "On disconnected";
-    Mutex::LockGuard lock(_mutex);
-    switch(_state) {
-        case State::wait_connect:
-            DEBUG << "Wait connect reset";
-            _state = State::started;
-            break;
-        case State::connected:
-            DEBUG << "Reset connected state";
-            _state = State::started;
-            break;
-        default:
-            ERROR << "Invalid state";
+    if(_status.Transit(State::wait_connect, State::started, true)) {
+        DEBUG << "Wait connect reset";
+    } else if(_status.Transit(State::connected, State::started, true)) {
+        DEBUG << "Reset connected state";
+    } else {
+        ERROR << "Invalid state";
+        _status.ClearIp();
     }
-    _hasIp = false;
 }
 
 void WiFi::OnStop()
 {
     INFO << "On stop";
-    Mutex::LockGuard lock(_mutex);
-    _state = State::none;
+    _status.Reset();
 }
 
-
 esp_err_t WiFi::StaticEventHandler(void* context, system_event_t* event)
 {
     WiFi* instance = reinterpret_cast<WiFi*>(context);
@@ -275,7 +271,6 @@ void WiFi::HandleEvent(const system_event_t& event)
 void WiFi::OnStationConnected(const system_event_ap_staconnected_t&)
 {
     DEBUG << "station connected to" << "access point";
-    Mutex::LockGuard lock(_mutex);
     if(!isStarted()) {
         ERROR << "Unexpected event";
         return;
@@ -285,7 +280,6 @@ void WiFi::OnStationConnected(const system_event_ap_staconnected_t&)
 void WiFi::OnStationDisconnected(const system_event_ap_stadisconnected_t&)
 {
     DEBUG << "station disconnected from" << "access point";
-    Mutex::LockGuard lock(_mutex);
     if(!isStarted()) {
         ERROR << "Unexpected event";
         return;
@@ -295,7 +289,6 @@ void WiFi::OnStationDisconnected(const system_event_ap_stadisconnected_t&)
 void WiFi::OnStationIpAssigned(const system_event_ap_staipassigned_t& event)
 {
     DEBUG << "station got ip from" << "access point";
-    Mutex::LockGuard lock(_mutex);
     if(!isStarted()) {
         ERROR << "Unexpected event";
         return;